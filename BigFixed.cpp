@@ -0,0 +1,340 @@
+#include "BigFixed.h"
+
+#include <algorithm>
+#include <math.h>
+
+BigFixed::BigFixed(double value, int fractionLimbs)
+    : m_limbs(static_cast<size_t>(std::max(fractionLimbs, 1)) + 1, 0u)
+{
+    m_negative = value < 0;
+    double v = fabs(value);
+    // Peel 32 bits at a time; a double has at most 53 significant bits, so this is exact
+    // for every value whose bits fall inside the limbs.
+    double whole = floor(v);
+    m_limbs[0] = static_cast<uint32_t>(whole);
+    v -= whole;
+    for (size_t i = 1; i < m_limbs.size() && v != 0; ++i)
+    {
+        v = ldexp(v, 32);
+        whole = floor(v);
+        m_limbs[i] = static_cast<uint32_t>(whole);
+        v -= whole;
+    }
+}
+
+void BigFixed::SetFractionLimbs(int fractionLimbs)
+{
+    m_limbs.resize(static_cast<size_t>(std::max(fractionLimbs, 1)) + 1, 0u);
+    if (IsZero()) m_negative = false;
+}
+
+BigFixed BigFixed::FromScaled(double value, int exponent, int fractionLimbs)
+{
+    BigFixed r(0.0, fractionLimbs);
+    if (value == 0)
+        return r;
+
+    // value = mant * 2^(k - 53) with mant a 53-bit integer; drop its bits one by one into the
+    // limbs that hold their weight.
+    int k = 0;
+    const double m = frexp(fabs(value), &k);
+    uint64_t mant = static_cast<uint64_t>(ldexp(m, 53));
+    for (int i = 0; i < 53; ++i, mant >>= 1)
+    {
+        if ((mant & 1) == 0) continue;
+        const long long w = static_cast<long long>(k) - 53 + i + exponent; // weight 2^w
+        if (w >= 32) continue; // beyond the integer limb: not a coordinate
+        const long long limb = w >= 0 ? 0 : (-w + 31) / 32;
+        if (limb >= static_cast<long long>(r.m_limbs.size())) continue;
+        r.m_limbs[static_cast<size_t>(limb)] |= 1u << static_cast<int>(w + 32 * limb);
+    }
+    r.m_negative = value < 0 && !r.IsZero();
+    return r;
+}
+
+int BigFixed::LimbsForScale(double scale, int scaleExp)
+{
+    int exponent = 0;
+    frexp(scale, &exponent); // scale = m * 2^exponent, 0.5 <= m < 1
+    const int bits = std::max(0, -(exponent + scaleExp)) + 64;
+    return (bits + 31) / 32;
+}
+
+bool BigFixed::IsZero() const
+{
+    for (uint32_t limb : m_limbs)
+        if (limb != 0) return false;
+    return true;
+}
+
+double BigFixed::ToDouble() const
+{
+    // Three limbs from the first non-zero one carry more than the 53 bits a double keeps.
+    size_t first = 0;
+    while (first < m_limbs.size() && m_limbs[first] == 0) ++first;
+
+    double v = 0;
+    for (size_t i = first; i < m_limbs.size() && i < first + 3; ++i)
+        v += ldexp(static_cast<double>(m_limbs[i]), -32 * static_cast<int>(i));
+    return m_negative ? -v : v;
+}
+
+double BigFixed::ToScaled(int exponent) const
+{
+    size_t first = 0;
+    while (first < m_limbs.size() && m_limbs[first] == 0) ++first;
+
+    double v = 0;
+    for (size_t i = first; i < m_limbs.size() && i < first + 3; ++i)
+        v += ldexp(static_cast<double>(m_limbs[i]), -32 * static_cast<int>(i) - exponent);
+    return m_negative ? -v : v;
+}
+
+void BigFixed::MulSmall(uint32_t factor)
+{
+    uint64_t carry = 0;
+    for (size_t i = m_limbs.size(); i-- > 0; )
+    {
+        uint64_t t = static_cast<uint64_t>(m_limbs[i]) * factor + carry;
+        m_limbs[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+}
+
+void BigFixed::DivSmall(uint32_t divisor)
+{
+    uint64_t rem = 0;
+    for (size_t i = 0; i < m_limbs.size(); ++i)
+    {
+        uint64_t t = (rem << 32) | m_limbs[i];
+        m_limbs[i] = static_cast<uint32_t>(t / divisor);
+        rem = t % divisor;
+    }
+}
+
+std::string BigFixed::ToString(int fractionDigits) const
+{
+    std::string text = m_negative ? "-" : "";
+    text += std::to_string(m_limbs[0]);
+    if (fractionDigits <= 0)
+        return text;
+
+    text += '.';
+    BigFixed frac = *this;
+    for (int i = 0; i < fractionDigits; ++i)
+    {
+        frac.m_limbs[0] = 0;
+        frac.MulSmall(10);
+        text += static_cast<char>('0' + frac.m_limbs[0]);
+    }
+    return text;
+}
+
+bool BigFixed::Parse(const char* text, int fractionLimbs, BigFixed& out)
+{
+    const char* p = text;
+    while (*p == ' ' || *p == '\t') ++p;
+
+    bool negative = false;
+    if (*p == '-' || *p == '+') negative = (*p++ == '-');
+
+    // Collect the mantissa digits and where the decimal point falls among them.
+    std::string digits;
+    long long point = 0;
+    while (*p >= '0' && *p <= '9') { digits += *p++; ++point; }
+    if (*p == '.')
+        for (++p; *p >= '0' && *p <= '9'; ) digits += *p++;
+    if (digits.empty())
+        return false;
+
+    if (*p == 'e' || *p == 'E')
+    {
+        ++p;
+        bool negExp = false;
+        if (*p == '-' || *p == '+') negExp = (*p++ == '-');
+        if (!(*p >= '0' && *p <= '9')) return false;
+        long long exponent = 0;
+        while (*p >= '0' && *p <= '9')
+            exponent = std::min(exponent * 10 + (*p++ - '0'), 1000000LL);
+        point += negExp ? -exponent : exponent;
+    }
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p != '\0')
+        return false;
+
+    // Digits past the limb precision cannot change the value, so cap the fraction length.
+    const long long maxFraction = 10LL * (std::max(fractionLimbs, 1) + 1);
+    if (point < -maxFraction)
+        point = -maxFraction;
+
+    BigFixed v(0.0, fractionLimbs);
+
+    // Fraction digits right to left: v = (digit + v) / 10. Positions before the first
+    // mantissa digit are zeros.
+    const long long len = static_cast<long long>(digits.size());
+    for (long long i = std::min(len, point + maxFraction); i-- > std::max(point, 0LL); )
+    {
+        v.m_limbs[0] = static_cast<uint32_t>(digits[static_cast<size_t>(i)] - '0');
+        v.DivSmall(10);
+    }
+    for (long long i = point; i < 0; ++i)
+        v.DivSmall(10);
+
+    // Integer digits left to right, padded with zeros when the exponent moves the point
+    // past the end of the mantissa.
+    uint64_t whole = 0;
+    for (long long i = 0; i < point; ++i)
+    {
+        whole = whole * 10 + (i < len ? static_cast<uint64_t>(digits[static_cast<size_t>(i)] - '0') : 0);
+        if (whole > 0xFFFFFFFFu) return false;
+    }
+    v.m_limbs[0] = static_cast<uint32_t>(whole);
+
+    v.m_negative = negative && !v.IsZero();
+    out = std::move(v);
+    return true;
+}
+
+int BigFixed::CompareMagnitude(const BigFixed& a, const BigFixed& b)
+{
+    const size_t n = std::max(a.m_limbs.size(), b.m_limbs.size());
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t x = i < a.m_limbs.size() ? a.m_limbs[i] : 0;
+        uint32_t y = i < b.m_limbs.size() ? b.m_limbs[i] : 0;
+        if (x != y) return x < y ? -1 : 1;
+    }
+    return 0;
+}
+
+void BigFixed::AddMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& out)
+{
+    const size_t n = std::max(a.m_limbs.size(), b.m_limbs.size());
+    out.m_limbs.assign(n, 0u);
+    uint64_t carry = 0;
+    for (size_t i = n; i-- > 0; )
+    {
+        uint64_t t = carry;
+        if (i < a.m_limbs.size()) t += a.m_limbs[i];
+        if (i < b.m_limbs.size()) t += b.m_limbs[i];
+        out.m_limbs[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+}
+
+void BigFixed::SubMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& out)
+{
+    const size_t n = std::max(a.m_limbs.size(), b.m_limbs.size());
+    out.m_limbs.assign(n, 0u);
+    int64_t borrow = 0;
+    for (size_t i = n; i-- > 0; )
+    {
+        int64_t t = -borrow;
+        if (i < a.m_limbs.size()) t += a.m_limbs[i];
+        if (i < b.m_limbs.size()) t -= b.m_limbs[i];
+        borrow = t < 0 ? 1 : 0;
+        out.m_limbs[i] = static_cast<uint32_t>(t + (borrow << 32));
+    }
+}
+
+BigFixed BigFixed::operator-() const
+{
+    BigFixed r = *this;
+    r.m_negative = !m_negative && !IsZero();
+    return r;
+}
+
+BigFixed BigFixed::operator+(const BigFixed& b) const
+{
+    BigFixed r;
+    if (m_negative == b.m_negative)
+    {
+        AddMagnitude(*this, b, r);
+        r.m_negative = m_negative;
+    }
+    else if (CompareMagnitude(*this, b) >= 0)
+    {
+        SubMagnitude(*this, b, r);
+        r.m_negative = m_negative;
+    }
+    else
+    {
+        SubMagnitude(b, *this, r);
+        r.m_negative = b.m_negative;
+    }
+    if (r.IsZero()) r.m_negative = false;
+    return r;
+}
+
+BigFixed BigFixed::operator-(const BigFixed& b) const
+{
+    return *this + (-b);
+}
+
+BigFixed BigFixed::operator*(const BigFixed& b) const
+{
+    // Schoolbook product of the magnitudes. Limb i has weight 2^(-32 i), so the product of
+    // limbs i and j lands at i + j; everything past the result precision is truncated.
+    const size_t n = std::max(m_limbs.size(), b.m_limbs.size());
+    std::vector<uint64_t> acc(n + 1, 0);   // position n collects the first dropped limb
+    for (size_t i = 0; i < m_limbs.size() && i <= n; ++i)
+    {
+        if (m_limbs[i] == 0) continue;
+        const size_t jEnd = std::min(b.m_limbs.size(), n + 1 - i);
+        for (size_t j = jEnd; j-- > 0; )
+        {
+            uint64_t t = static_cast<uint64_t>(m_limbs[i]) * b.m_limbs[j];
+            // Accumulate low and high halves separately so acc never overflows.
+            acc[i + j] += static_cast<uint32_t>(t);
+            if (i + j > 0) acc[i + j - 1] += t >> 32;
+        }
+    }
+
+    BigFixed r;
+    r.m_limbs.assign(n, 0u);
+    uint64_t carry = 0;
+    for (size_t k = n + 1; k-- > 0; )
+    {
+        uint64_t t = acc[k] + carry;
+        if (k < n) r.m_limbs[k] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    r.m_negative = (m_negative != b.m_negative) && !r.IsZero();
+    return r;
+}
+
+BigFixed BigFixed::Square() const
+{
+    // Same as operator* but each cross product is computed once and doubled.
+    const size_t n = m_limbs.size();
+    std::vector<uint64_t> acc(n + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (m_limbs[i] == 0) continue;
+        for (size_t j = i; j < n && i + j <= n; ++j)
+        {
+            uint64_t t = static_cast<uint64_t>(m_limbs[i]) * m_limbs[j];
+            uint64_t lo = static_cast<uint32_t>(t), hi = t >> 32;
+            if (i != j) { lo <<= 1; hi <<= 1; }
+            acc[i + j] += lo;
+            if (i + j > 0) acc[i + j - 1] += hi;
+        }
+    }
+
+    BigFixed r;
+    r.m_limbs.assign(n, 0u);
+    uint64_t carry = 0;
+    for (size_t k = n + 1; k-- > 0; )
+    {
+        uint64_t t = acc[k] + carry;
+        if (k < n) r.m_limbs[k] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    r.m_negative = false;
+    return r;
+}
+
+bool BigFixed::operator==(const BigFixed& b) const
+{
+    return m_negative == b.m_negative && CompareMagnitude(*this, b) == 0;
+}
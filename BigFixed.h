@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Arbitrary-precision signed fixed-point number for deep-zoom coordinates.
+//
+// The magnitude is stored as 32-bit limbs, most significant first: limb 0 is the integer
+// part and limbs 1..n are the fraction, so the resolution is 2^(-32 n). Mandelbrot
+// coordinates and orbit values stay far below 2^32 before escaping, so one integer limb is
+// plenty. Operands of different precision are fine; results take the larger precision.
+class BigFixed
+{
+public:
+    BigFixed() : BigFixed(0.0, 2) {}
+    explicit BigFixed(double value, int fractionLimbs = 2);
+
+    // value * 2^exponent, exact down to the limb precision (for offsets below the double range).
+    static BigFixed FromScaled(double value, int exponent, int fractionLimbs);
+
+    int FractionLimbs() const { return static_cast<int>(m_limbs.size()) - 1; }
+
+    // Changes the precision; extending is exact, shrinking truncates.
+    void SetFractionLimbs(int fractionLimbs);
+
+    double ToDouble() const;
+
+    // value * 2^-exponent as a double: offsets below the double range in units of 2^exponent
+    // (the inverse of FromScaled).
+    double ToScaled(int exponent) const;
+
+    // Decimal text with the given number of digits after the point (no exponent).
+    std::string ToString(int fractionDigits) const;
+
+    // Parses "[-]digits[.digits][e[+|-]digits]". Returns false on malformed text.
+    static bool Parse(const char* text, int fractionLimbs, BigFixed& out);
+
+    BigFixed operator-() const;
+    BigFixed operator+(const BigFixed& b) const;
+    BigFixed operator-(const BigFixed& b) const;
+    BigFixed operator*(const BigFixed& b) const;
+    BigFixed Square() const;
+    bool operator==(const BigFixed& b) const;
+    bool operator!=(const BigFixed& b) const { return !(*this == b); }
+
+    // Fraction limbs needed to address pixels of spacing scale * 2^scaleExp, with 64 guard bits.
+    static int LimbsForScale(double scale, int scaleExp = 0);
+
+private:
+    bool IsZero() const;
+    void MulSmall(uint32_t factor);             // magnitude *= factor (must not overflow the integer limb)
+    void DivSmall(uint32_t divisor);            // magnitude /= divisor, truncating
+    static int CompareMagnitude(const BigFixed& a, const BigFixed& b);
+    static void AddMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& out);
+    static void SubMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& out); // |a| >= |b|
+
+    bool m_negative = false;
+    std::vector<uint32_t> m_limbs; // [0] integer part, [1..] fraction, most significant first
+};
@@ -0,0 +1,72 @@
+#include "FloatExp.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+FloatExp::FloatExp(double mantissa, int exponent)
+{
+    int k = 0;
+    m = frexp(mantissa, &k);
+    e = m == 0 ? 0 : exponent + k;
+}
+
+double FloatExp::ToDouble() const
+{
+    return ldexp(m, e);
+}
+
+double FloatExp::Log2Abs() const
+{
+    return log2(fabs(m)) + e;
+}
+
+std::string FloatExp::ToString(int digits) const
+{
+    char buf[64];
+    if (m == 0 || (e > -1000 && e < 1000))
+    {
+        snprintf(buf, sizeof(buf), "%.*g", digits, ToDouble());
+        return buf;
+    }
+
+    // Split log10 |value| into a decimal exponent and a mantissa in [1, 10).
+    const double log10Value = Log2Abs() * log10(2.0);
+    double exp10 = floor(log10Value);
+    double mant10 = pow(10.0, log10Value - exp10);
+    if (mant10 >= 10.0) { mant10 /= 10.0; exp10 += 1.0; }
+    snprintf(buf, sizeof(buf), "%.*fe%+.0f", digits > 1 ? digits - 1 : 0, m < 0 ? -mant10 : mant10, exp10);
+    return buf;
+}
+
+bool FloatExp::Parse(const char* text, FloatExp& out)
+{
+    // strtod reads the mantissa only; the exponent is read as an integer so it can lie far
+    // outside the double range.
+    const std::string str(text);
+    const size_t ePos = str.find_first_of("eE");
+    const std::string mantissaText = str.substr(0, ePos);
+
+    char* end = nullptr;
+    const double mantissa = strtod(mantissaText.c_str(), &end);
+    if (end == mantissaText.c_str() || *end != '\0')
+        return false;
+
+    long exp10 = 0;
+    if (ePos != std::string::npos)
+    {
+        const char* expText = str.c_str() + ePos + 1;
+        exp10 = strtol(expText, &end, 10);
+        if (end == expText)
+            return false;
+        while (*end == ' ' || *end == '\t') ++end;
+        if (*end != '\0')
+            return false;
+    }
+
+    // mantissa * 10^exp10 = mantissa * 2^(exp10 log2 10); split off the integer power of two.
+    const double log2Scale = exp10 * log2(10.0);
+    const double whole = floor(log2Scale);
+    out = FloatExp(mantissa * exp2(log2Scale - whole), static_cast<int>(whole));
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+// Double mantissa with a separate binary exponent: value = m * 2^e. Used for the pixel spacing
+// and other view-level quantities once zooms go below the double range (about 1e-308). The
+// perturbation kernel keeps its own lazily normalized form for speed; this type is for the
+// per-frame setup and the UI, so it normalizes on every operation.
+struct FloatExp
+{
+    double m = 0.0; // 0.5 <= |m| < 1, or 0
+    int e = 0;
+
+    FloatExp() {}
+    explicit FloatExp(double mantissa, int exponent = 0);
+
+    double ToDouble() const;            // 0 or +-inf outside the double range
+    double Log2Abs() const;             // log2 |value|, -inf for 0
+
+    FloatExp operator*(double b) const { return FloatExp(m * b, e); }
+    FloatExp operator/(double b) const { return FloatExp(m / b, e); }
+
+    // Decimal text with the given significant digits, e.g. "1.2345e-400".
+    std::string ToString(int digits) const;
+
+    // Parses a decimal number with an optional exponent of any size. Returns false on malformed text.
+    static bool Parse(const char* text, FloatExp& out);
+};
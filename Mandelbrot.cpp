@@ -11,19 +11,53 @@
 //   Right-drag  - select a rectangle (selection is shown as an overlay)
 //   Left-click inside the selection - open a new window framed on that selection
 //   R           - reset view
+//   Z           - zoom out 2x around the center (reuses the last frame as the new center)
+//   S           - toggle smooth coloring
+//   H           - toggle histogram coloring
+//   A           - toggle automatic max iterations (chosen per frame from a probe grid)
+//   N           - toggle adaptive antialiasing
+//   D           - toggle distance estimation (filaments drawn at least a pixel wide)
+//   T           - toggle the tile cache (zooms step by 2x so revisited views come from cache)
 //   + / -       - increase/decrease max iterations
 //   Esc / Close - exit
+//
+// Command line:
+//   --kernel=scalar|sse2|avx2|avx512 - force an escape-time kernel (for A/B benchmarking);
+//                                      by default the widest one the CPU supports is used
+//   --precision=auto|float|double|dd - lane type; auto uses float for shallow views and
+//                                      double-double (dd) past double's resolution
+//   --no-rebase                      - deep zooms: no rebasing of perturbation pixels, so
+//                                      glitch correction does all the work (for comparison)
+//   --palette=<file>                 - color with a gradient file (see Gradient::Load); quote
+//                                      paths with spaces
+//   --aa=<n>                         - antialias edges with n x n jittered samples (2 to 8,
+//                                      default 4)
+//   --tile-cache=<MB>                - turn the tile cache on with this memory budget
+//                                      (default 256)
 
 #include "PropertiesDlg.h"
+#include "Palette.h"
+#include "Perturbation.h"
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include "TileCache.h"
 #include "resource.h"
 
 #include <windows.h>
 #include <windowsx.h>
+#include <commdlg.h>
 #include <stdint.h>
 #include <math.h>
-#include <cassert>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <format>
+#include <thread>
+#include <vector>
 
 extern AppState g_state;
 
@@ -33,16 +67,208 @@ extern AppState g_state;
 #define ID_ITER_INC     9003
 #define ID_ITER_DEC     9004
 #define ID_HELP_ABOUT   9005
-
-static inline double PixelToWorldX(int px)
+#define ID_MODE_BRUTE   9006
+#define ID_MODE_MARIANI 9007
+#define ID_MODE_PROGRESSIVE 9008
+#define ID_VIEW_ZOOM_OUT 9009
+#define ID_FILE_LOAD_PALETTE 9010
+#define ID_FILE_DEFAULT_PALETTE 9011
+#define ID_VIEW_SMOOTH  9012
+#define ID_VIEW_HISTOGRAM 9013
+#define ID_VIEW_AUTO_ITER 9014
+#define ID_VIEW_ANTIALIAS 9015
+#define ID_VIEW_DISTANCE 9016
+#define ID_VIEW_TILE_CACHE 9017
+
+// World offset of a pixel from the view center, in units of 2^scaleExp. Navigation works in
+// offsets so it stays exact at zoom depths where the world coordinate itself no longer fits
+// in a double.
+static inline double PixelOffsetX(double px)
 {
-    return g_state.centerX + (px - (g_state.width / 2.0)) * g_state.scale;
+    return (px - (g_state.width / 2.0)) * g_state.scale;
 }
 
-static inline double PixelToWorldY(int py)
+static inline double PixelOffsetY(double py)
 {
     // Note the '-' here: pixel y grows downward, world imaginary should grow upward.
-    return g_state.centerY - (py - (g_state.height / 2.0)) * g_state.scale;
+    return -(py - (g_state.height / 2.0)) * g_state.scale;
+}
+
+// Sets the exact center, with enough precision for the current scale (set the scale first).
+// The pan anchor moves along, so the next frame is on a new pixel grid.
+static void SetCenter(const BigFixed& re, const BigFixed& im)
+{
+    const int limbs = BigFixed::LimbsForScale(g_state.scale, g_state.scaleExp);
+    g_state.centerRe = re;
+    g_state.centerIm = im;
+    if (g_state.centerRe.FractionLimbs() < limbs) g_state.centerRe.SetFractionLimbs(limbs);
+    if (g_state.centerIm.FractionLimbs() < limbs) g_state.centerIm.SetFractionLimbs(limbs);
+    g_state.centerX = g_state.centerRe.ToDouble();
+    g_state.centerY = g_state.centerIm.ToDouble();
+    g_state.panAnchorRe = g_state.centerRe;
+    g_state.panAnchorIm = g_state.centerIm;
+    g_state.panX = g_state.panY = 0;
+}
+
+// Puts the center panX / panY whole pixels right of / below the pan anchor. The anchor stays,
+// so the new frame's pixels coincide with the previous frame's and the render thread only
+// computes the strips the pan exposes.
+static void PanView(int panX, int panY)
+{
+    const BigFixed anchorRe = g_state.panAnchorRe, anchorIm = g_state.panAnchorIm;
+    const int limbs = BigFixed::LimbsForScale(g_state.scale, g_state.scaleExp);
+    SetCenter(anchorRe + BigFixed::FromScaled(panX * g_state.scale, g_state.scaleExp, limbs),
+              anchorIm + BigFixed::FromScaled(-panY * g_state.scale, g_state.scaleExp, limbs));
+    g_state.panAnchorRe = anchorRe;
+    g_state.panAnchorIm = anchorIm;
+    g_state.panX = panX;
+    g_state.panY = panY;
+}
+
+// Moves the center by (dx, dy) * 2^scaleExp world units (call before SetScale when zooming).
+static void OffsetCenter(double dx, double dy)
+{
+    const int limbs = BigFixed::LimbsForScale(g_state.scale, g_state.scaleExp);
+    SetCenter(g_state.centerRe + BigFixed::FromScaled(dx, g_state.scaleExp, limbs),
+              g_state.centerIm + BigFixed::FromScaled(dy, g_state.scaleExp, limbs));
+}
+
+// Sets the pixel spacing to mantissa * 2^exponent. Spacings a double can hold with room for
+// the pixel offsets are stored as a plain scale; below 2^kMinPlainScaleExponent the exponent
+// is kept separately in scaleExp and the view renders with scaled perturbation.
+static void SetScale(double mantissa, int exponent)
+{
+    const FloatExp s(mantissa, exponent);
+    if (s.m == 0)
+        return;
+    if (s.e > kMinPlainScaleExponent)
+    {
+        g_state.scale = s.ToDouble();
+        g_state.scaleExp = 0;
+    }
+    else
+    {
+        g_state.scale = s.m;
+        g_state.scaleExp = s.e;
+    }
+    SetCenter(g_state.centerRe, g_state.centerIm);
+}
+
+// Doubles the pixel spacing around the view center (to within half a pixel) on the current
+// pixel grid, so every other pixel of the last frame is exactly a pixel of the new one and the
+// render thread only computes the outer ring.
+static void ZoomOutOnGrid()
+{
+    const BigFixed anchorRe = g_state.panAnchorRe, anchorIm = g_state.panAnchorIm;
+    const int panX = (int)floor(g_state.panX / 2.0), panY = (int)floor(g_state.panY / 2.0);
+    SetScale(g_state.scale * 2.0, g_state.scaleExp);
+    g_state.panAnchorRe = anchorRe;
+    g_state.panAnchorIm = anchorIm;
+    PanView(panX, panY);
+}
+
+static void ResetView()
+{
+    SetScale(3.0 / 800.0, 0);
+    SetCenter(BigFixed(-0.75), BigFixed(0.0));
+}
+
+// With the tile cache on, moves the view onto the tile grid (see FindTileGrid): the pixel
+// spacing to the nearest power of two and the center to the nearest pixel of it, or half a
+// pixel off for an odd window size, where the center falls between pixels. Pans keep the view
+// on the grid from there. Views whose center a double no longer places to the pixel are left
+// alone; the cache does not take them.
+static void SnapToTileGrid()
+{
+    if (!g_state.tileCache || g_state.scaleExp != 0)
+        return;
+    const double s = exp2(round(log2(g_state.scale)));
+    if (fabs(g_state.centerX) / s >= 0x1p52 || fabs(g_state.centerY) / s >= 0x1p52)
+        return;
+    SetScale(s, 0);
+    auto snap = [s](double center, int pixels)
+    {
+        const double half = pixels % 2 ? 0.5 : 0.0;
+        return BigFixed((round(center / s - half) + half) * s, BigFixed::LimbsForScale(s));
+    };
+    SetCenter(snap(g_state.centerX, g_state.width), snap(g_state.centerY, g_state.height));
+}
+
+// Colors frames with the gradient in the file from now on. Reports a file that cannot be
+// used and keeps the current colors.
+static bool LoadPalette(const char* path)
+{
+    auto gradient = std::make_shared<Gradient>();
+    std::string error;
+    if (!Gradient::Load(path, *gradient, error))
+    {
+        MessageBoxA(NULL, error.c_str(), "Mandelbrot", MB_ICONERROR);
+        return false;
+    }
+    g_state.gradient = std::move(gradient);
+    return true;
+}
+
+// Switches between coloring by escape count and by the fractional (smooth) count. The
+// iteration buffers already hold what both need, so the frame is only recolored.
+static void ToggleSmoothColoring(HWND hwnd)
+{
+    g_state.smoothColoring = !g_state.smoothColoring;
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_SMOOTH, MF_BYCOMMAND | (g_state.smoothColoring ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Switches between spreading the colors evenly over the escape counts and over the pixels
+// (histogram equalization). Like smooth coloring this only recolors the frame.
+static void ToggleHistogramColoring(HWND hwnd)
+{
+    g_state.histogramColoring = !g_state.histogramColoring;
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_HISTOGRAM, MF_BYCOMMAND | (g_state.histogramColoring ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Switches between the hand-set max iterations and choosing them per frame. Switching off
+// keeps the last choice, so the frame on screen does not change.
+static void ToggleAutoIterations(HWND hwnd)
+{
+    g_state.autoIter = !g_state.autoIter;
+    if (!g_state.autoIter && g_state.stats.maxIter > 0)
+        g_state.maxIter = g_state.stats.maxIter;
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_AUTO_ITER, MF_BYCOMMAND | (g_state.autoIter ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Adaptive antialiasing supersamples the edges of the colored frame; switching it only
+// redoes the colorization phase and what follows.
+static void ToggleAntialiasing(HWND hwnd)
+{
+    g_state.antialias = !g_state.antialias;
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_ANTIALIAS, MF_BYCOMMAND | (g_state.antialias ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Distance estimation needs its own kernels, so switching it iterates the frame again.
+static void ToggleDistanceEstimation(HWND hwnd)
+{
+    g_state.distanceEstimation = !g_state.distanceEstimation;
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_DISTANCE, MF_BYCOMMAND | (g_state.distanceEstimation ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// The tile cache keeps the iterated tiles of frames on the tile grid, so switching it on moves
+// the view onto the grid; switching it off frees the tiles with the next frame.
+static void ToggleTileCache(HWND hwnd)
+{
+    g_state.tileCache = !g_state.tileCache;
+    SnapToTileGrid();
+    CheckMenuItem(GetMenu(hwnd), ID_VIEW_TILE_CACHE, MF_BYCOMMAND | (g_state.tileCache ? MF_CHECKED : MF_UNCHECKED));
+    g_state.needRender = true;
+    InvalidateRect(hwnd, NULL, FALSE);
 }
 
 static void NormalizeRect(RECT& r)
@@ -56,110 +282,784 @@ static bool PointInRectEx(const RECT& r, int x, int y)
     return (x >= r.left && x <= r.right && y >= r.top && y <= r.bottom);
 }
 
-static void CreateOrResizeBitmap(int w, int h)
+static void ResizeView(int w, int h)
 {
-    if (g_state.hBitmap)
-    {
-        DeleteObject(g_state.hBitmap);
-        g_state.hBitmap = nullptr;
-        g_state.pixels = nullptr;
-        g_state.pitch = 0; // clear pitch when freeing existing bitmap
-    }
-
+    // The frame on screen keeps its size until the render thread delivers one of the new size.
     g_state.width = w;
     g_state.height = h;
+    SnapToTileGrid(); // an odd size puts the center between pixels
+    g_state.needRender = true;
+}
 
-    // Prepare BITMAPINFO for 32bpp (top-down)
-    ZeroMemory(&g_state.bmi, sizeof(g_state.bmi));
-    g_state.bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    g_state.bmi.bmiHeader.biWidth = w;
-    g_state.bmi.bmiHeader.biHeight = -h; // negative = top-down DIB
-    g_state.bmi.bmiHeader.biPlanes = 1;
-    g_state.bmi.bmiHeader.biBitCount = 32;
-    g_state.bmi.bmiHeader.biCompression = BI_RGB;
+// Posted by the render thread when a finished frame waits in g_render.ready.
+#define WM_FRAME_READY (WM_APP + 1)
 
+// Everything the render thread needs from g_state for one frame, copied by the UI thread.
+struct FrameRequest
+{
+    HWND hwnd = nullptr;          // receives WM_FRAME_READY (and progressive passes)
+    unsigned number = 0;
+    int width = 0, height = 0;
+    BigFixed centerRe, centerIm;  // pan anchor: pixels are placed relative to it
+    double centerX = 0.0, centerY = 0.0;
+    int panX = 0, panY = 0;       // view center in pixels from the anchor (see AppState)
+    BigFixed viewRe, viewIm;      // exact view center, for drawing the frame as a preview
+    double scale = 0.0;
+    int scaleExp = 0;
+    int maxIter = 0;
+    RenderMode mode = RenderMode::BruteForce;
+    KernelIsa kernelIsa = KernelIsa::Scalar;
+    KernelPrecision precision = KernelPrecision::Auto;
+    bool rebase = true;
+    int rmin = 0, rmax = 0;
+    int gmin = 0, gmax = 0;
+    int bmin = 0, bmax = 0;
+    std::shared_ptr<const Gradient> gradient;
+    bool smoothColoring = false;
+    bool histogramColoring = false;
+    bool autoIter = false;
+    int aaSamples = 0;            // antialiasing: samples per axis of edge pixels; 0: off
+    bool distance = false;
+    size_t tileCacheBytes = 0;    // tile cache: memory budget; 0: off (and emptied)
+};
+
+// Render thread. The UI thread never touches pixels: WM_PAINT posts the current view as a
+// request, the thread renders it into a frame buffer of its own and posts WM_FRAME_READY,
+// and the UI thread swaps that buffer in as g_state.frame. A newer request cancels the frame
+// in flight at the next tile. lock guards everything but cancel and the thread-only members.
+static struct RenderThread
+{
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    FrameRequest request;         // latest view asked for
+    bool pending = false;         // request not picked up yet
+    bool stop = false;
+    std::atomic<bool> cancel{ false };
+
+    FrameBuffer ready;            // finished frame waiting for the UI thread
+    FrameStats readyStats;
+    FrameBuffer spare;            // frame the UI thread replaced, handed back for reuse
+
+    // Render thread only.
+    FrameBuffer back;             // frame being rendered
+    std::vector<int> iterations;  // escape count per pixel of back, colored into its pixels
+    std::vector<float> norms;     // |z|^2 at escape per pixel of back, for smooth coloring
+    Palette palette;              // colors of the frame being rendered
+    unsigned lastPalette = 0;     // palette version the last finished frame was colored with
+    std::vector<std::vector<uint32_t>> histograms; // histogram coloring: escape counts per pool worker
+    std::vector<int> probeIterations; // automatic iterations: the probe grid
+    std::vector<float> probeNorms;
+    int autoMaxIter = 0;          // automatic iterations: last choice; 0: none yet
+    std::vector<uint8_t> edges;   // antialiasing: pixels of back to supersample
+    TileCache tileCache;          // iteration data of frames on the tile grid
+    FrameRequest last;            // view of the last finished frame (its pixels are with the UI thread)
+    FrameParams lastParams;       // what it was rendered with
+    double lastReachX = 0.0, lastReachY = 0.0; // perturbation: its series / BLA reach, in pixels
+    bool lastValid = false;       // iterations still hold it
+    ReferenceOrbit reference;     // orbit of referenceRe/Im, reused while center and maxIter stay
+    BigFixed referenceRe, referenceIm;
+    std::vector<ReferenceOrbit> glitchReferences; // extra references of the last glitch correction
+} g_render;
+
+static std::unique_ptr<ThreadPool> g_renderPool;
+
+static FrameBuffer CreateFrameBuffer(int w, int h)
+{
+    BITMAPINFO bmi;
+    ZeroMemory(&bmi, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = w;
+    bmi.bmiHeader.biHeight = -h; // negative = top-down DIB
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    FrameBuffer fb;
     void* bits = nullptr;
-    g_state.hBitmap = CreateDIBSection(NULL, &g_state.bmi, DIB_RGB_COLORS, &bits, NULL, 0);
-    g_state.pixels = bits;
+    fb.bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!fb.bitmap)
+        return FrameBuffer();
+    fb.pixels = static_cast<uint32_t*>(bits);
+    fb.width = w;
+    fb.height = h;
+
+    // Scanlines are DWORD-aligned, which 32 bpp always is.
+    const int pitch = ((32 * w + 31) / 32) * 4;
+    fb.pitchPixels = pitch / sizeof(uint32_t);
+    return fb;
+}
 
-    // Compute pitch (bytes per scanline), DWORD-aligned:
-    int bpp = g_state.bmi.bmiHeader.biBitCount;
-    g_state.pitch = ((bpp * w + 31) / 32) * 4;
+static void DeleteFrameBuffer(FrameBuffer& fb)
+{
+    if (fb.bitmap) DeleteObject(fb.bitmap);
+    fb = FrameBuffer();
+}
 
-    g_state.needRender = true;
+static void BlitFrame(HDC hdc, const FrameBuffer& fb)
+{
+    HDC memDC = CreateCompatibleDC(hdc);
+    HGDIOBJ old = SelectObject(memDC, fb.bitmap);
+    BitBlt(hdc, 0, 0, fb.width, fb.height, memDC, 0, 0, SRCCOPY);
+    SelectObject(memDC, old);
+    DeleteDC(memDC);
 }
 
-static void RenderMandelbrot()
+// Draws a finished frame where its view falls in the current one (UI thread). Until the
+// render thread catches up with a pan or zoom, the frame on screen is shifted and stretched
+// around the same anchor as the navigation, as a preview; the rest of the window is black.
+static void DrawFrame(HDC hdc, const FrameBuffer& fb)
 {
-    if (!g_state.pixels) return;
+    // Frame pixels per window pixel, and the offset of the frame's center from the view's.
+    const double ratio = ldexp(fb.scale / g_state.scale, fb.scaleExp - g_state.scaleExp);
+    const double dx = (fb.centerRe - g_state.centerRe).ToScaled(g_state.scaleExp) / g_state.scale;
+    const double dy = -(fb.centerIm - g_state.centerIm).ToScaled(g_state.scaleExp) / g_state.scale;
 
-    HWND hwnd = GetActiveWindow();
-    HDC hdc = GetDC(hwnd);
-    RECT r{};
-    GetClientRect(hwnd, &r);
-    SetBkMode(hdc, TRANSPARENT);
-    SetTextColor(hdc, RGB(255, 255, 255));
-    std::string text{ "Rendering ..." };
-    DrawTextA(hdc, text.c_str(), static_cast<int>(text.length()), &r, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-    ReleaseDC(hwnd, hdc);
+    RECT client = { 0, 0, g_state.width, g_state.height };
+    if (ratio == 1.0 && dx == 0.0 && dy == 0.0 && fb.width == g_state.width && fb.height == g_state.height)
+    {
+        BlitFrame(hdc, fb);
+        return;
+    }
 
-    const int w = g_state.width;
-    const int h = g_state.height;
-    const double cx = g_state.centerX;
-    const double cy = g_state.centerY;
-    const double scale = g_state.scale;
-    const int maxIter = g_state.maxIter;
+    const double left = g_state.width / 2.0 + dx - fb.width / 2.0 * ratio;
+    const double top = g_state.height / 2.0 + dy - fb.height / 2.0 * ratio;
+    const double right = left + fb.width * ratio, bottom = top + fb.height * ratio;
+    const double limit = 1e7; // stretched past this the frame is a blur of one pixel anyway
+    if (!(fabs(left) < limit && fabs(top) < limit && fabs(right) < limit && fabs(bottom) < limit))
+    {
+        FillRect(hdc, &client, static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH)));
+        return;
+    }
 
-    uint32_t* buf = static_cast<uint32_t*>(g_state.pixels);
+    RECT dst = { lround(left), lround(top), lround(right), lround(bottom) };
+    HDC memDC = CreateCompatibleDC(hdc);
+    HGDIOBJ old = SelectObject(memDC, fb.bitmap);
+    SetStretchBltMode(hdc, COLORONCOLOR);
+    StretchBlt(hdc, dst.left, dst.top, dst.right - dst.left, dst.bottom - dst.top, memDC, 0, 0, fb.width, fb.height, SRCCOPY);
+    SelectObject(memDC, old);
+    DeleteDC(memDC);
+
+    // Bands around the frame: above, below, then left and right of it.
+    const HBRUSH black = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));
+    const RECT bands[4] = {
+        { 0, 0, client.right, (std::max)(0L, dst.top) },
+        { 0, (std::min)(client.bottom, dst.bottom), client.right, client.bottom },
+        { 0, dst.top, (std::max)(0L, dst.left), dst.bottom },
+        { (std::min)(client.right, dst.right), dst.top, client.right, dst.bottom },
+    };
+    for (const RECT& band : bands)
+        if (band.right > band.left && band.bottom > band.top)
+            FillRect(hdc, &band, black);
+}
 
-    const double halfW = w / 2.0;
-    const double halfH = h / 2.0;
+// New references glitch correction may add per frame.
+static const int kMaxGlitchReferences = 32;
+
+// Automatic iterations: probe spacing in pixels (a power of two, so probes are exact frame
+// pixels), share of the probes that may still escape after the chosen maxIter, and its range.
+static const int kProbeStep = 16;
+static const double kAutoIterUnresolved = 0.001;
+static const int kMinAutoIter = 64;
+static const int kMaxAutoIter = 1 << 18;
+
+// Perturbation setup of a frame: the reference orbit at the pan anchor for f.maxIter
+// iterations (kept while anchor and maxIter stay), the series and the BLA table for the
+// view's reach, and the perturbation kernels in f. Called again when automatic iterations
+// raise f.maxIter.
+static void PreparePerturbation(const FrameRequest& view, FrameParams& f, FrameStats& stats, double& reachX, double& reachY)
+{
+    ReferenceOrbit& reference = g_render.reference;
+    const bool stale = reference.maxIter != f.maxIter ||
+                       g_render.referenceRe != view.centerRe || g_render.referenceIm != view.centerIm ||
+                       g_render.referenceRe.FractionLimbs() != view.centerRe.FractionLimbs();
+    if (stale)
+    {
+        const auto refStart = std::chrono::steady_clock::now();
+        ComputeReferenceOrbit(view.centerRe, view.centerIm, f.maxIter, reference);
+        g_render.referenceRe = view.centerRe;
+        g_render.referenceIm = view.centerIm;
+        stats.referenceMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - refStart).count();
+    }
+    // Pixels reach (reachX, reachY) from the reference; rounding the pan up to quarter-window
+    // steps keeps the series and the BLA table (and so the pixels) the same while a pan
+    // stays within a step.
+    reachX = 0.25 * f.width * ceil(2.0 + 4.0 * abs(view.panX) / f.width);
+    reachY = 0.25 * f.height * ceil(2.0 + 4.0 * abs(view.panY) / f.height);
+    ApproximateSeries(reference, reachX * f.scale, reachY * f.scale, f.scale, f.scaleExp);
+
+    // The BLA table depends on the reference and the view's reach only, so it is rebuilt
+    // when either changes and not on recolors or repaints.
+    const double dcMax = ldexp(hypot(reachX, reachY) * f.scale, f.scaleExp);
+    if (reference.bla.dcMax != dcMax)
+    {
+        const auto blaStart = std::chrono::steady_clock::now();
+        BuildBlaTable(reference, dcMax, *g_renderPool);
+        stats.blaMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - blaStart).count();
+    }
+    stats.referenceIterations = (int)reference.zx.size() - 1;
+    stats.seriesIterations = reference.series.iterations;
+    stats.blaLevels = (int)reference.bla.levels.size();
+
+    f.centerX = 0.0;
+    f.centerY = 0.0;
+    f.centerXLo = 0.0;
+    f.centerYLo = 0.0;
+    f.reference = &reference;
+    f.rebase = view.rebase;
+    f.iterateRow = IterateRowPerturbation;
+    f.iteratePixel = IterateRowPerturbation;
+    stats.lanePrecision = KernelPrecision::Double;
+}
 
-    // If your surface has a row stride (pitch) different from w*4, use it.
-    // Example: size_t pitchPixels = g_state.pitch ? (g_state.pitch / 4) : (size_t)w;
-    size_t pitchPixels = (g_state.pitch && g_state.pitch > 0) ? (g_state.pitch / sizeof(uint32_t)) : (size_t)w;
+// Renders the view into g_render.back (render thread only). Returns false when a newer
+// request cancelled the frame; the buffer is then partly rendered.
+static bool RenderMandelbrot(const FrameRequest& view, FrameStats& stats)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    stats = FrameStats();
+    stats.frame = view.number;
+
+    FrameParams f{};
+    f.width = view.width;
+    f.height = view.height;
+    f.centerX = view.centerX;
+    f.centerY = view.centerY;
+    f.scale = view.scale;
+    f.scaleExp = view.scaleExp;
+    // Pixel (x, y) sits at anchor + (x - halfW, halfH - y) * scale; shifting the halves by the
+    // pan keeps every pixel's coordinate bit-identical to the frame it was panned from.
+    f.halfW = f.width / 2.0 - view.panX;
+    f.halfH = f.height / 2.0 - view.panY;
+    f.maxIter = view.maxIter;
+    f.mode = view.mode;
+    f.iterations = g_render.iterations.data();
+    f.norms = g_render.norms.data();
+    f.pixels = g_render.back.pixels;
+    f.pitchPixels = g_render.back.pitchPixels;
+    f.cancel = &g_render.cancel;
+
+    // Shallow views fit in float, which doubles the lanes per instruction; past double's
+    // resolution the double-double kernels carry the view down to about 1e-28. The view's
+    // extent decides it, so panning keeps the same choice until the coordinates themselves grow.
+    const double minX = f.centerX - f.halfW * f.scale, maxX = f.centerX + (f.width - f.halfW) * f.scale;
+    const double minY = f.centerY - (f.height - f.halfH) * f.scale, maxY = f.centerY + f.halfH * f.scale;
+    KernelPrecision lanes = view.precision;
+    if (lanes == KernelPrecision::Auto)
+    {
+        if (FloatPrecisionSuffices(minX, maxX, minY, maxY, f.scale))
+            lanes = KernelPrecision::Float;
+        else if (DoublePrecisionSuffices(minX, maxX, minY, maxY, f.scale))
+            lanes = KernelPrecision::Double;
+        else
+            lanes = KernelPrecision::DoubleDouble;
+    }
+    stats.lanePrecision = lanes;
+
+    // The double-double kernels add the part of the exact center that centerX/Y drop.
+    f.centerXLo = (view.centerRe - BigFixed(view.centerX, view.centerRe.FractionLimbs())).ToDouble();
+    f.centerYLo = (view.centerIm - BigFixed(view.centerY, view.centerIm.FractionLimbs())).ToDouble();
+
+    // All kernels of one precision return identical counts; kernelIsa only changes how fast we get them.
+    f.iterateRow = GetRowKernel(view.kernelIsa, lanes, view.distance);
+    f.iteratePixel = GetRowKernel(KernelIsa::Scalar, lanes, view.distance);
+
+    // Past double-double precision, iterate offsets from a reference orbit at the pan anchor
+    // (the exact center until the view is panned). Spacings below the double range
+    // (scaleExp != 0) always take this path.
+    double reachX = 0.0, reachY = 0.0;
+    stats.perturbation = f.scaleExp != 0 || !DoubleDoublePrecisionSuffices(minX, maxX, minY, maxY, f.scale);
+    if (view.autoIter)
+        f.maxIter = (std::min)(kMaxAutoIter, 2 * (std::max)(kMinAutoIter, g_render.autoMaxIter ? g_render.autoMaxIter : view.maxIter));
+    if (stats.perturbation)
+        PreparePerturbation(view, f, stats, reachX, reachY);
+
+    // Automatic iterations: probe every kProbeStep-th pixel at a cap of at least twice the last
+    // choice and take the smallest maxIter that leaves at most kAutoIterUnresolved of the probes
+    // escaping after it. Probes still running at the cap are taken as inside the set once that
+    // maxIter is at most half the cap; otherwise escapes have not died down yet and the cap is
+    // doubled. The last choice is kept while it is within a factor two above the new one, so
+    // pans and recolors keep the iterations they can reuse; a new choice gets a quarter of
+    // headroom for the same reason.
+    if (view.autoIter)
+    {
+        const int probeW = (f.width + kProbeStep - 1) / kProbeStep;
+        const int probeH = (f.height + kProbeStep - 1) / kProbeStep;
+        std::vector<int>& probes = g_render.probeIterations;
+        std::vector<float>& probeNorms = g_render.probeNorms;
+        probes.resize((size_t)probeW * probeH);
+        probeNorms.resize(probes.size());
+
+        int needed = kMinAutoIter;
+        std::vector<int> escaped;
+        for (;;)
+        {
+            const auto probeStart = std::chrono::steady_clock::now();
+            IterateProbeGrid(f, kProbeStep, probes.data(), probeNorms.data(), *g_renderPool);
+            stats.probeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - probeStart).count();
+            stats.probePixels += (long long)probes.size();
+            if (Cancelled(f))
+                return false;
+
+            // Glitched probes are left out; their count is where the glitch showed, not an escape.
+            escaped.clear();
+            long long counted = 0;
+            for (int n : probes)
+            {
+                if (IsGlitched(n))
+                    continue;
+                ++counted;
+                if (n < f.maxIter)
+                    escaped.push_back(n);
+            }
+            const size_t allowed = (size_t)(kAutoIterUnresolved * counted);
+            needed = kMinAutoIter;
+            if (escaped.size() > allowed)
+            {
+                std::nth_element(escaped.begin(), escaped.end() - 1 - allowed, escaped.end());
+                needed = (std::max)(kMinAutoIter, *(escaped.end() - 1 - allowed) + 1);
+            }
+            if (2 * needed <= f.maxIter || f.maxIter == kMaxAutoIter)
+                break;
+            f.maxIter = (std::min)(kMaxAutoIter, 2 * f.maxIter);
+            if (stats.perturbation)
+                PreparePerturbation(view, f, stats, reachX, reachY);
+        }
 
-    for (int y = 0; y < h; ++y)
+        const int previous = g_render.autoMaxIter;
+        if (needed <= previous && previous <= 2 * needed && previous <= f.maxIter)
+            f.maxIter = previous;
+        else
+            f.maxIter = (std::min)(f.maxIter, needed + needed / 4);
+        g_render.autoMaxIter = f.maxIter;
+    }
+    stats.maxIter = f.maxIter;
+
+    // The perturbation kernels carry no derivative, so deep frames render without distance
+    // estimation. Distance frames keep the estimate where smooth coloring keeps |z|^2, so they
+    // color by escape count.
+    f.distance = view.distance && !stats.perturbation;
+    stats.distance = f.distance;
+    g_render.palette.Update(f.maxIter, view.smoothColoring && !f.distance ? kSmoothSteps : 1, view.gradient,
+                            view.rmin, view.rmax, view.gmin, view.gmax, view.bmin, view.bmax);
+    f.palette = g_render.palette.Table();
+    f.paletteSteps = g_render.palette.Steps();
+
+    // A frame on the tile grid is assembled from the tile cache and iterates only the tiles it
+    // misses. The cache also holds what the last frame would lend it, so it takes over from
+    // reusing that.
+    TileCache& tileCache = g_render.tileCache;
+    tileCache.SetBudget(view.tileCacheBytes);
+    TileGrid grid;
+    const bool cached = view.tileCacheBytes && FindTileGrid(f, grid);
+
+    // A frame on the last finished frame's pixel grid reuses the iterations they share: a pan
+    // moves them over, an exact 2x zoom-out keeps every other one as its center, and a
+    // change of colors alone keeps them all. Only the rest is iterated.
+    const FrameRequest& last = g_render.last;
+    const FrameParams& lp = g_render.lastParams;
+    int reuseStep = 0;          // last frame's pixels per pixel of this one; 0: render in full
+    int offX = 0, offY = 0;     // pixel (x, y) is last pixel (reuseStep x + offX, reuseStep y + offY)
+    if (!cached && g_render.lastValid && view.width == last.width && view.height == last.height && view.mode == last.mode &&
+        view.centerRe == last.centerRe && view.centerIm == last.centerIm &&
+        view.centerRe.FractionLimbs() == last.centerRe.FractionLimbs() &&
+        f.maxIter == lp.maxIter && f.iterateRow == lp.iterateRow && f.rebase == lp.rebase)
     {
-        double imag = cy - (y - halfH) * scale;
-        assert(pitchPixels == 4);
-        uint32_t* row = buf + (size_t)y * pitchPixels;
-        for (int x = 0; x < w; ++x)
+        if (f.scale == lp.scale && f.scaleExp == lp.scaleExp && reachX == g_render.lastReachX && reachY == g_render.lastReachY)
+        {
+            reuseStep = 1;
+            offX = view.panX - last.panX;
+            offY = view.panY - last.panY;
+        }
+        else if (!stats.perturbation && f.scaleExp == 0 && lp.scaleExp == 0 && f.scale == 2.0 * lp.scale)
         {
-            double real = cx + (x - halfW) * scale; // <-- fixed mapping
+            // Doubling the spacing is exact, so (x - halfW) * scale matches the last frame's
+            // (x' - halfW') * scale' bit for bit wherever x' - halfW' = 2 (x - halfW). Deep
+            // views change their series and BLA with the spacing and render in full.
+            const double ox = lp.halfW - 2.0 * f.halfW, oy = lp.halfH - 2.0 * f.halfH;
+            if (ox == floor(ox) && oy == floor(oy))
+            {
+                reuseStep = 2;
+                offX = (int)ox;
+                offY = (int)oy;
+            }
+        }
+    }
 
-            double zx = 0.0, zy = 0.0;
-            double zx2 = 0.0, zy2 = 0.0;
-            int iter = 0;
+    // Pixels with a counterpart in the last frame: [keptX0, keptX1) x [keptY0, keptY1).
+    auto ceilDiv = [](int a, int b) { return a >= 0 ? (a + b - 1) / b : -(-a / b); };
+    const int keptX0 = reuseStep ? (std::max)(0, ceilDiv(-offX, reuseStep)) : 0;
+    const int keptX1 = reuseStep ? (std::min)(f.width, ceilDiv(f.width - offX, reuseStep)) : 0;
+    const int keptY0 = reuseStep ? (std::max)(0, ceilDiv(-offY, reuseStep)) : 0;
+    const int keptY1 = reuseStep ? (std::min)(f.height, ceilDiv(f.height - offY, reuseStep)) : 0;
+    const bool reuse = keptX0 < keptX1 && keptY0 < keptY1;
+
+    // With the same colors the kept pixels are copied too. The last frame's pixels are with the
+    // UI thread, which never deletes the frame on screen or the one waiting for it before this
+    // thread delivers another. It may move the waiting frame on screen meanwhile, clearing its
+    // slot, so the bitmap's pixels are taken under the lock and the slot is not read again.
+    // Histogram coloring depends on every pixel and antialiasing on their neighbours, so
+    // neither copies.
+    const uint32_t* previousPixels = nullptr;
+    size_t previousPitch = 0;
+    if (reuse && !view.histogramColoring && !view.aaSamples && g_render.palette.Version() == g_render.lastPalette)
+    {
+        std::lock_guard<std::mutex> lock(g_render.lock);
+        if (g_render.ready.bitmap && g_render.readyStats.frame == last.number)
+        {
+            previousPixels = g_render.ready.pixels;
+            previousPitch = g_render.ready.pitchPixels;
+        }
+        else if (g_state.frame.bitmap && g_state.stats.frame == last.number)
+        {
+            previousPixels = g_state.frame.pixels;
+            previousPitch = g_state.frame.pitchPixels;
+        }
+    }
+    const bool copyPixels = previousPixels != nullptr;
+    g_render.lastValid = false;
 
-            while (zx2 + zy2 <= 4.0 && iter < maxIter)
+    // Tile-sized pieces of the rectangles to iterate and color.
+    struct Piece { int x0, y0, w, h; };
+    std::vector<Piece> pieces;
+    auto addStrip = [&](int x0, int y0, int w, int h)
+    {
+        for (int y = y0; y < y0 + h; y += kTileSize)
+            for (int x = x0; x < x0 + w; x += kTileSize)
+                pieces.push_back({ x, y, (std::min)(kTileSize, x0 + w - x), (std::min)(kTileSize, y0 + h - y) });
+    };
+
+    const int tilesX = (f.width + kTileSize - 1) / kTileSize;
+    const int tilesY = (f.height + kTileSize - 1) / kTileSize;
+    std::atomic<long long> skipped{ 0 };
+    std::atomic<long long> computed{ 0 };
+    std::atomic<long long> guessed{ 0 };
+    if (cached)
+    {
+        // Missed tiles are iterated whole, also where they stick out of the frame, so they can
+        // be stored; a cancelled frame stores none.
+        std::vector<TileKey> keys;
+        CoveringTiles(f, grid, keys);
+        std::vector<const CachedTile*> found(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            found[i] = tileCache.Find(keys[i]);
+            stats.cacheHits += found[i] ? 1 : 0;
+        }
+        std::vector<CachedTile> missed(keys.size());
+        g_renderPool->ParallelFor((int)keys.size(), [&](int i, int)
+        {
+            if (Cancelled(f))
+                return;
+            if (!found[(size_t)i])
             {
-                zy = 2.0 * zx * zy + imag;
-                zx = zx2 - zy2 + real;
-                zx2 = zx * zx;
-                zy2 = zy * zy;
-                ++iter;
+                TileStats tileStats;
+                IterateCacheTile(f, grid, keys[(size_t)i], missed[(size_t)i], tileStats);
+                skipped += tileStats.skipped;
+                computed += tileStats.computed;
+                guessed += tileStats.guessed;
             }
+            CopyCacheTile(f, grid, keys[(size_t)i], found[(size_t)i] ? *found[(size_t)i] : missed[(size_t)i]);
+        });
+        if (!Cancelled(f))
+            for (size_t i = 0; i < keys.size(); ++i)
+                if (!found[i])
+                    tileCache.Store(keys[i], std::move(missed[i]));
+        stats.cacheTiles = (int)keys.size();
+    }
+    else if (reuse)
+    {
+        if (reuseStep == 1)
+            ScrollFrame(f, previousPixels, previousPitch, offX, offY);
+        else
+        {
+            const std::vector<int> lastIterations = g_render.iterations;
+            const std::vector<float> lastNorms = g_render.norms;
+            ShrinkFrame(f, lastIterations.data(), lastNorms.data(), previousPixels, previousPitch, offX, offY,
+                        keptX0, keptY0, keptX1, keptY1);
+        }
 
-            uint8_t r = 0, g = 0, b = 0;
-            if (iter >= maxIter)
+        // The rest: whole rows above and below the kept ones, then columns beside them.
+        addStrip(0, 0, f.width, keptY0);
+        addStrip(0, keptY1, f.width, f.height - keptY1);
+        addStrip(0, keptY0, keptX0, keptY1 - keptY0);
+        addStrip(keptX1, keptY0, f.width - keptX1, keptY1 - keptY0);
+
+        g_renderPool->ParallelFor((int)pieces.size(), [&](int i, int)
+        {
+            if (Cancelled(f))
+                return;
+            const Piece& p = pieces[(size_t)i];
+            TileStats tileStats;
+            IterateRect(f, p.x0, p.y0, p.w, p.h, tileStats);
+            skipped += tileStats.skipped;
+            computed += tileStats.computed;
+        });
+        stats.reusedPixels = (long long)(keptX1 - keptX0) * (keptY1 - keptY0);
+    }
+    else if (f.mode == RenderMode::Progressive)
+    {
+        // Every pass covers the whole image and goes on screen before the next finer one starts.
+        for (int step = kFirstPassStep; step >= 1 && !Cancelled(f); step /= 2)
+        {
+            g_renderPool->ParallelFor(tilesX * tilesY, [&](int tile, int)
             {
-                // inside - black
-                r = g = b = 0;
-            }
-            else
+                if (Cancelled(f))
+                    return;
+                TileStats tileStats;
+                RenderTilePass(f, tile % tilesX, tile / tilesX, step, tileStats);
+                skipped += tileStats.skipped;
+                computed += tileStats.computed;
+                guessed += tileStats.guessed;
+            });
+
+            if (step == kFirstPassStep)
+                stats.firstPassMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            if (step > 1 && !Cancelled(f))
             {
-                r = (uint8_t)(g_state.rmin + (((g_state.rmax - g_state.rmin) * iter) / maxIter));
-                g = (uint8_t)(g_state.gmin + (((g_state.gmax - g_state.gmin) * iter) / maxIter));
-                b = (uint8_t)(g_state.bmin + (((g_state.bmax - g_state.bmin) * iter) / maxIter));
+                HDC windowDC = GetDC(view.hwnd);
+                BlitFrame(windowDC, g_render.back);
+                ReleaseDC(view.hwnd, windowDC);
             }
+        }
+    }
+    else
+    {
+        g_renderPool->ParallelFor(tilesX * tilesY, [&](int tile, int)
+        {
+            if (Cancelled(f))
+                return;
+            TileStats tileStats;
+            IterateTile(f, tile % tilesX, tile / tilesX, tileStats);
+            skipped += tileStats.skipped;
+            computed += tileStats.computed;
+        });
+    }
+    stats.skippedPixels = skipped;
+    stats.computedPixels = computed;
+    stats.guessedPixels = guessed;
+
+    if (stats.perturbation)
+        CorrectGlitches(f, view.centerRe, view.centerIm, kMaxGlitchReferences, g_render.glitchReferences,
+                        *g_renderPool, stats.glitches);
+    if (Cancelled(f))
+        return false;
+
+    // Colorization runs over the finished iteration buffer: the new pieces when the kept
+    // pixels were copied, the whole frame otherwise.
+    auto colorStart = std::chrono::steady_clock::now();
+    stats.iterationMs = std::chrono::duration<double, std::milli>(colorStart - startTime).count();
+    if (!copyPixels)
+    {
+        pieces.clear();
+        addStrip(0, 0, f.width, f.height);
+    }
 
-            // memory order: B G R [A/0]
-            uint32_t pixel = (uint32_t)b | ((uint32_t)g << 8) | ((uint32_t)r << 16);
-            row[x] = pixel;
+    // Histogram coloring counts the escape counts of the finished buffer, where reused pixels
+    // and glitch corrections have landed, rather than in the kernels: each worker adds its tiles
+    // to a private histogram, so the iteration phase runs exactly as without it, and the merged
+    // histogram equalizes the palette for the colorization pass.
+    if (view.histogramColoring)
+    {
+        auto& histograms = g_render.histograms;
+        histograms.resize((size_t)g_renderPool->WorkerCount());
+        for (auto& h : histograms)
+            h.assign((size_t)f.maxIter, 0);
+        g_renderPool->ParallelFor((int)pieces.size(), [&](int i, int worker)
+        {
+            const Piece& p = pieces[(size_t)i];
+            CountIterations(f, p.x0, p.y0, p.w, p.h, histograms[(size_t)worker].data());
+        });
+        for (size_t w = 1; w < histograms.size(); ++w)
+            for (int n = 0; n < f.maxIter; ++n)
+                histograms[0][(size_t)n] += histograms[w][(size_t)n];
+        g_render.palette.Equalize(histograms[0]);
+        f.palette = g_render.palette.Table();
+
+        const auto histogramEnd = std::chrono::steady_clock::now();
+        stats.histogramMs = std::chrono::duration<double, std::milli>(histogramEnd - colorStart).count();
+        colorStart = histogramEnd;
+    }
+    g_renderPool->ParallelFor((int)pieces.size(), [&](int i, int)
+    {
+        const Piece& p = pieces[(size_t)i];
+        ColorizeRect(f, p.x0, p.y0, p.w, p.h);
+    });
+    for (const Piece& p : pieces)
+        stats.coloredPixels += (long long)p.w * p.h;
+    auto endTime = std::chrono::steady_clock::now();
+    stats.colorMs = std::chrono::duration<double, std::milli>(endTime - colorStart).count();
+
+    // Antialiasing marks the edges of the whole colored frame first, then supersamples only
+    // those, so its cost follows the length of the boundaries rather than the frame size.
+    if (view.aaSamples)
+    {
+        g_render.edges.resize((size_t)f.width * f.height);
+        uint8_t* edges = g_render.edges.data();
+        g_renderPool->ParallelFor((int)pieces.size(), [&](int i, int)
+        {
+            const Piece& p = pieces[(size_t)i];
+            FindEdges(f, p.x0, p.y0, p.w, p.h, edges);
+        });
+        std::atomic<long long> supersampled{ 0 };
+        g_renderPool->ParallelFor((int)pieces.size(), [&](int i, int)
+        {
+            if (Cancelled(f))
+                return;
+            const Piece& p = pieces[(size_t)i];
+            supersampled += SupersampleRect(f, edges, view.aaSamples, p.x0, p.y0, p.w, p.h);
+        });
+        if (Cancelled(f))
+            return false;
+        stats.supersampledPixels = supersampled;
+        stats.aaSamples = view.aaSamples;
+
+        const auto aaEnd = std::chrono::steady_clock::now();
+        stats.aaMs = std::chrono::duration<double, std::milli>(aaEnd - endTime).count();
+        endTime = aaEnd;
+    }
+    stats.renderMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    g_render.last = view;
+    g_render.lastParams = f;
+    g_render.lastPalette = g_render.palette.Version();
+    g_render.lastReachX = reachX;
+    g_render.lastReachY = reachY;
+    g_render.lastValid = true;
+    stats.cacheBytes = tileCache.Bytes();
+    return true;
+}
+
+static void RenderThreadMain()
+{
+    for (;;)
+    {
+        FrameRequest view;
+        {
+            std::unique_lock<std::mutex> lock(g_render.lock);
+            g_render.wake.wait(lock, [] { return g_render.stop || g_render.pending; });
+            if (g_render.stop)
+                break;
+            view = g_render.request;
+            g_render.pending = false;
+            g_render.cancel = false;
+
+            // Reuse the frame the UI thread gave back when ours went to the screen.
+            if (g_render.spare.bitmap && (g_render.back.width != view.width || g_render.back.height != view.height))
+                std::swap(g_render.back, g_render.spare);
+        }
+
+        if (g_render.back.width != view.width || g_render.back.height != view.height)
+        {
+            DeleteFrameBuffer(g_render.back);
+            g_render.back = CreateFrameBuffer(view.width, view.height);
+            if (!g_render.back.bitmap)
+                continue;
+        }
+        g_render.iterations.resize((size_t)view.width * view.height);
+        g_render.norms.resize((size_t)view.width * view.height);
+
+        FrameStats stats;
+        if (!RenderMandelbrot(view, stats))
+            continue;
+
+        {
+            // A frame the UI thread has not picked up yet is replaced; its buffer is reused.
+            std::lock_guard<std::mutex> lock(g_render.lock);
+            g_render.back.centerRe = view.viewRe;
+            g_render.back.centerIm = view.viewIm;
+            g_render.back.scale = view.scale;
+            g_render.back.scaleExp = view.scaleExp;
+            std::swap(g_render.ready, g_render.back);
+            g_render.readyStats = stats;
         }
+        PostMessage(view.hwnd, WM_FRAME_READY, 0, 0);
+    }
+
+    DeleteFrameBuffer(g_render.back);
+}
+
+// Hands the current view to the render thread and cancels the frame in flight (UI thread).
+static void RequestFrame(HWND hwnd)
+{
+    FrameRequest view;
+    view.hwnd = hwnd;
+    view.number = ++g_state.requestedFrame;
+    view.width = g_state.width;
+    view.height = g_state.height;
+    view.centerRe = g_state.panAnchorRe;
+    view.centerIm = g_state.panAnchorIm;
+    view.centerX = view.centerRe.ToDouble();
+    view.centerY = view.centerIm.ToDouble();
+    view.panX = g_state.panX;
+    view.panY = g_state.panY;
+    view.viewRe = g_state.centerRe;
+    view.viewIm = g_state.centerIm;
+    view.scale = g_state.scale;
+    view.scaleExp = g_state.scaleExp;
+    view.maxIter = g_state.maxIter;
+    view.mode = g_state.renderMode;
+    view.kernelIsa = g_state.kernelIsa;
+    view.precision = g_state.precision;
+    view.rebase = g_state.rebase;
+    view.rmin = g_state.rmin; view.rmax = g_state.rmax;
+    view.gmin = g_state.gmin; view.gmax = g_state.gmax;
+    view.bmin = g_state.bmin; view.bmax = g_state.bmax;
+    view.gradient = g_state.gradient;
+    view.smoothColoring = g_state.smoothColoring;
+    view.histogramColoring = g_state.histogramColoring;
+    view.autoIter = g_state.autoIter;
+    view.aaSamples = g_state.antialias ? g_state.aaSamples : 0;
+    view.distance = g_state.distanceEstimation;
+    view.tileCacheBytes = g_state.tileCache ? (size_t)g_state.tileCacheMB << 20 : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(g_render.lock);
+        g_render.request = std::move(view);
+        g_render.pending = true;
+        g_render.cancel = true;
     }
-    g_state.needRender = false;
+    g_render.wake.notify_one();
+}
+
+// Swaps the finished frame in for display (UI thread, on WM_FRAME_READY). The replaced frame
+// goes back to the render thread for reuse.
+static void PresentFrame(HWND hwnd)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_render.lock);
+        if (!g_render.ready.bitmap)
+            return;
+        DeleteFrameBuffer(g_render.spare);
+        g_render.spare = g_state.frame;
+        g_state.frame = g_render.ready;
+        g_render.ready = FrameBuffer();
+        g_state.stats = g_render.readyStats;
+    }
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+static void StartRenderThread()
+{
+    g_render.thread = std::thread(RenderThreadMain);
+}
+
+// Cancels the frame in flight and waits for the thread, then frees every frame buffer.
+static void StopRenderThread()
+{
+    if (!g_render.thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(g_render.lock);
+        g_render.stop = true;
+        g_render.cancel = true;
+    }
+    g_render.wake.notify_one();
+    g_render.thread.join();
+
+    DeleteFrameBuffer(g_render.ready);
+    DeleteFrameBuffer(g_render.spare);
+    DeleteFrameBuffer(g_state.frame);
 }
 
 void ApplySelectionToWindow(HWND hwnd)
@@ -176,17 +1076,17 @@ void ApplySelectionToWindow(HWND hwnd)
     double selCenterPx = (sel.left + sel.right) / 2.0;
     double selCenterPy = (sel.top + sel.bottom) / 2.0;
 
-    // world coords of selection center (use PixelToWorldY with the correct sign)
-    double worldX = PixelToWorldX(static_cast<int>(selCenterPx + 0.5));
-    double worldY = PixelToWorldY(static_cast<int>(selCenterPy + 0.5));
+    // world offset of selection center (use PixelOffsetY with the correct sign)
+    double offsetX = PixelOffsetX(static_cast<int>(selCenterPx + 0.5));
+    double offsetY = PixelOffsetY(static_cast<int>(selCenterPy + 0.5));
 
     // new scale: selected width in pixels maps to full window width
     double newScale = g_state.scale * (static_cast<double>(selW) / static_cast<double>(g_state.width));
 
     // apply to current AppState and re-render
-    g_state.centerX = worldX;
-    g_state.centerY = worldY;
-    g_state.scale = newScale;
+    OffsetCenter(offsetX, offsetY);
+    SetScale(newScale, g_state.scaleExp);
+    SnapToTileGrid();
     g_state.selecting = false;
     g_state.hasSelection = false;
     g_state.needRender = true;
@@ -207,10 +1107,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         g_state.bmin = 0;
         g_state.bmax = 0;
 
-        // Create initial bitmap sized to client area
+        // Size the view to the client area; the first WM_PAINT requests its frame
         RECT client;
         GetClientRect(hwnd, &client);
-        CreateOrResizeBitmap((client.right - client.left), (client.bottom - client.top));
+        ResizeView((client.right - client.left), (client.bottom - client.top));
         return 0;
     }
 
@@ -220,7 +1120,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         int h = HIWORD(lParam);
         if (w > 0 && h > 0)
         {
-            CreateOrResizeBitmap(w, h);
+            ResizeView(w, h);
             InvalidateRect(hwnd, NULL, FALSE);
         }
         return 0;
@@ -237,14 +1137,15 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 // real current values (prevents stale values from being applied unintentionally).
                 extern Properties g_props;
                 g_props.maxIter = g_state.maxIter;
-                g_props.centerReal = g_state.centerX;
-                g_props.centerImag = g_state.centerY;
+                g_props.centerReal = g_state.centerRe;
+                g_props.centerImag = g_state.centerIm;
                 // Dialog expects "Height (world units)" -> scale = height / pixelHeight
                 // so height in world units is scale * pixelHeight
                 if (g_state.height > 0)
-                    g_props.height = g_state.scale * (double)g_state.height;
+                    g_props.height = FloatExp(g_state.scale, g_state.scaleExp) * (double)g_state.height;
                 else
-                    g_props.height = 0.0;
+                    g_props.height = FloatExp();
+                const FloatExp height = g_props.height;
                 g_props.rmin = g_state.rmin; g_props.rmax = g_state.rmax;
                 g_props.gmin = g_state.gmin; g_props.gmax = g_state.gmax;
                 g_props.bmin = g_state.bmin; g_props.bmax = g_state.bmax;
@@ -252,13 +1153,18 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 INT_PTR res = DialogBox(nullptr, MAKEINTRESOURCE(IDD_PROPERTIES), hwnd, PropertiesDlgProc);
                 if (res == IDOK)
                 {
-                    // apply values from dialog
+                    // apply values from dialog; an unchanged view keeps its pan anchor and
+                    // iteration buffer, so a change of colors alone only recolors the frame
                     g_state.maxIter = g_props.maxIter;
-                    g_state.centerX = g_props.centerReal;
-                    g_state.centerY = g_props.centerImag;
                     // convert dialog "Height (world units)" to scale (world units per pixel)
-                    if (g_state.height > 0)
-                        g_state.scale = g_props.height / (double)g_state.height;
+                    if (g_state.height > 0 && (g_props.height.m != height.m || g_props.height.e != height.e))
+                    {
+                        const FloatExp scale = g_props.height / (double)g_state.height;
+                        SetScale(scale.m, scale.e);
+                    }
+                    if (g_props.centerReal != g_state.centerRe || g_props.centerImag != g_state.centerIm)
+                        SetCenter(g_props.centerReal, g_props.centerImag);
+                    SnapToTileGrid();
                     g_state.rmin = g_props.rmin; g_state.rmax = g_props.rmax;
                     g_state.gmin = g_props.gmin; g_state.gmax = g_props.gmax;
                     g_state.bmin = g_props.bmin; g_state.bmax = g_props.bmax;
@@ -271,13 +1177,58 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             case ID_FILE_EXIT:
                 PostMessage(hwnd, WM_CLOSE, 0, 0);
                 break;
+            case ID_FILE_LOAD_PALETTE:
+            {
+                char path[MAX_PATH] = "";
+                OPENFILENAMEA ofn = { 0 };
+                ofn.lStructSize = sizeof(ofn);
+                ofn.hwndOwner = hwnd;
+                ofn.lpstrFilter = "Palette files (*.txt)\0*.txt\0All files (*.*)\0*.*\0";
+                ofn.lpstrFile = path;
+                ofn.nMaxFile = sizeof(path);
+                ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+                if (GetOpenFileNameA(&ofn) && LoadPalette(path))
+                {
+                    g_state.needRender = true;
+                    InvalidateRect(hwnd, NULL, FALSE);
+                }
+                break;
+            }
+            case ID_FILE_DEFAULT_PALETTE:
+                g_state.gradient.reset();
+                g_state.needRender = true;
+                InvalidateRect(hwnd, NULL, FALSE);
+                break;
             case ID_VIEW_RESET:
-                g_state.centerX = -0.75;
-                g_state.centerY = 0.0;
-                g_state.scale = 3.0 / 800.0;
+                ResetView();
+                SnapToTileGrid();
                 g_state.needRender = true;
                 InvalidateRect(hwnd, NULL, FALSE);
                 break;
+            case ID_VIEW_ZOOM_OUT:
+                ZoomOutOnGrid();
+                SnapToTileGrid();
+                g_state.needRender = true;
+                InvalidateRect(hwnd, NULL, FALSE);
+                break;
+            case ID_VIEW_SMOOTH:
+                ToggleSmoothColoring(hwnd);
+                break;
+            case ID_VIEW_HISTOGRAM:
+                ToggleHistogramColoring(hwnd);
+                break;
+            case ID_VIEW_AUTO_ITER:
+                ToggleAutoIterations(hwnd);
+                break;
+            case ID_VIEW_ANTIALIAS:
+                ToggleAntialiasing(hwnd);
+                break;
+            case ID_VIEW_DISTANCE:
+                ToggleDistanceEstimation(hwnd);
+                break;
+            case ID_VIEW_TILE_CACHE:
+                ToggleTileCache(hwnd);
+                break;
             case ID_ITER_INC:
                 g_state.maxIter = static_cast<int>(g_state.maxIter * 1.25) + 10;
                 if (g_state.maxIter > 5000) g_state.maxIter = 5000;
@@ -290,6 +1241,15 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
                 g_state.needRender = true;
                 InvalidateRect(hwnd, NULL, FALSE);
                 break;
+            case ID_MODE_BRUTE:
+            case ID_MODE_MARIANI:
+            case ID_MODE_PROGRESSIVE:
+                g_state.renderMode = (id == ID_MODE_MARIANI) ? RenderMode::MarianiSilver
+                                   : (id == ID_MODE_PROGRESSIVE) ? RenderMode::Progressive : RenderMode::BruteForce;
+                CheckMenuRadioItem(GetMenu(hwnd), ID_MODE_BRUTE, ID_MODE_PROGRESSIVE, id, MF_BYCOMMAND);
+                g_state.needRender = true;
+                InvalidateRect(hwnd, NULL, FALSE);
+                break;
             case ID_HELP_ABOUT:
                 MessageBoxW(hwnd, L"Mandelbrot Renderer\n\nSimple Win32 Mandelbrot explorer", L"About", MB_OK | MB_ICONINFORMATION);
                 break;
@@ -326,8 +1286,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         g_state.dragging = true;
         g_state.dragStart.x = mx;
         g_state.dragStart.y = my;
-        g_state.dragCenterX = g_state.centerX;
-        g_state.dragCenterY = g_state.centerY;
+        // Far from the anchor a deep view's reference orbit would sit outside the frame;
+        // start a new grid at the current center instead.
+        if (abs(g_state.panX) > g_state.width || abs(g_state.panY) > g_state.height)
+            SetCenter(g_state.centerRe, g_state.centerIm);
+        g_state.dragPanX = g_state.panX;
+        g_state.dragPanY = g_state.panY;
         SetCapture(hwnd);
         return 0;
     }
@@ -347,8 +1311,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             int y = HIWORD(lParam);
             int dx = x - g_state.dragStart.x;
             int dy = y - g_state.dragStart.y;
-            g_state.centerX = g_state.dragCenterX - dx * g_state.scale;
-            g_state.centerY = g_state.dragCenterY + dy * g_state.scale;
+            PanView(g_state.dragPanX - dx, g_state.dragPanY - dy);
             g_state.needRender = true;
             InvalidateRect(hwnd, NULL, FALSE);
         }
@@ -459,24 +1422,20 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
         double oldScale = g_state.scale;
         double factor = (delta > 0) ? 0.8 : 1.25;
-        // Use exponential for smooth zoom
-        double zoomFactor = pow(factor, abs(delta) / 120.0);
+        // Use exponential for smooth zoom; the tile cache zooms a level (2x) per wheel message
+        double zoomFactor = g_state.tileCache ? ((delta > 0) ? 0.5 : 2.0) : pow(factor, abs(delta) / 120.0);
         double newScale = oldScale * zoomFactor;
 
-        // Compute world position under mouse using the same sign convention as the renderer:
-        double worldX = PixelToWorldX(mp.x);
-        double worldY = PixelToWorldY(mp.y);
-
-        // New center: keep the world point under the mouse stationary:
-        // For X: worldX = newCenterX + (mp.x - halfW)*newScale  => newCenterX = worldX - (mp.x - halfW)*newScale
-        // For Y: worldY = newCenterY - (mp.y - halfH)*newScale  => newCenterY = worldY + (mp.y - halfH)*newScale
-        double halfW = g_state.width / 2.0;
-        double halfH = g_state.height / 2.0;
+        // Offset of the world point under the mouse, using the same sign convention as the renderer:
+        double offsetX = PixelOffsetX(mp.x);
+        double offsetY = PixelOffsetY(mp.y);
 
-        g_state.centerX = worldX - (mp.x - halfW) * newScale;
-        g_state.centerY = worldY + (mp.y - halfH) * newScale; // note the + here to match PixelToWorldY's '-'
-
-        g_state.scale = newScale;
+        // New center: keep the world point under the mouse stationary. It is center + offset
+        // now and has to be newCenter + offset * newScale / oldScale after the zoom, so the
+        // center moves by offset * (1 - zoomFactor).
+        OffsetCenter(offsetX * (1.0 - zoomFactor), offsetY * (1.0 - zoomFactor));
+        SetScale(newScale, g_state.scaleExp);
+        SnapToTileGrid();
 
         g_state.needRender = true;
         InvalidateRect(hwnd, NULL, FALSE);
@@ -487,12 +1446,42 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     {
         if (wParam == 'R')
         {
-            g_state.centerX = -0.75;
-            g_state.centerY = 0.0;
-            g_state.scale = 3.0 / 800.0;
+            ResetView();
+            SnapToTileGrid();
             g_state.needRender = true;
             InvalidateRect(hwnd, NULL, FALSE);
         }
+        else if (wParam == 'Z')
+        {
+            ZoomOutOnGrid();
+            SnapToTileGrid();
+            g_state.needRender = true;
+            InvalidateRect(hwnd, NULL, FALSE);
+        }
+        else if (wParam == 'S')
+        {
+            ToggleSmoothColoring(hwnd);
+        }
+        else if (wParam == 'H')
+        {
+            ToggleHistogramColoring(hwnd);
+        }
+        else if (wParam == 'A')
+        {
+            ToggleAutoIterations(hwnd);
+        }
+        else if (wParam == 'N')
+        {
+            ToggleAntialiasing(hwnd);
+        }
+        else if (wParam == 'D')
+        {
+            ToggleDistanceEstimation(hwnd);
+        }
+        else if (wParam == 'T')
+        {
+            ToggleTileCache(hwnd);
+        }
         else if (wParam == VK_ESCAPE)
         {
             PostMessage(hwnd, WM_CLOSE, 0, 0);
@@ -518,34 +1507,94 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
 
+        // Input only marks the view dirty; by the time WM_PAINT arrives the queued input has
+        // been handled, so a burst of drags or wheel steps becomes one request.
         if (g_state.needRender)
         {
-            RenderMandelbrot();
+            RequestFrame(hwnd);
+            g_state.needRender = false;
         }
 
-        if (g_state.hBitmap)
+        if (g_state.frame.bitmap)
         {
-            HDC memDC = CreateCompatibleDC(hdc);
-            HGDIOBJ old = SelectObject(memDC, g_state.hBitmap);
-            BitBlt(hdc, 0, 0, g_state.width, g_state.height, memDC, 0, 0, SRCCOPY);
-            SelectObject(memDC, old);
-            DeleteDC(memDC);
+            DrawFrame(hdc, g_state.frame);
         }
         else
         {
             FillRect(hdc, &ps.rcPaint, reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1));
         }
 
-        // Draw simple overlay text
+        // Draw the overlay text, one line per group: view, kernel, timing, and reuse, cache and
+        // antialiasing. A single line would run off the right edge long before the last groups;
+        // a group wider than the window wraps onto more lines.
         {
             constexpr int D = std::numeric_limits<double>::max_digits10;
-            std::string info = "Center: " + std::format("{:.{}g}", g_state.centerX, D) + " + " + std::format("{:.{}g}", g_state.centerY, D) + "i" +
-                                "  Scale: " + std::format("{:.{}g}", g_state.scale, D) +
-                                "  Iter: " + std::to_string(g_state.maxIter);
+            // Statistics are those of the frame on screen, which lags the view while rendering.
+            const FrameStats& st = g_state.stats;
+            const double framePixels = (std::max)(1.0, (double)g_state.frame.width * g_state.frame.height);
+            std::string view = "Center: " + std::format("{:.{}g}", g_state.centerX, D) + " + " + std::format("{:.{}g}", g_state.centerY, D) + "i" +
+                                "  Scale: " + FloatExp(g_state.scale, g_state.scaleExp).ToString(D) +
+                                "  Iter: " + (g_state.autoIter
+                                    ? std::to_string(st.maxIter) + " (auto, probe " + std::format("{:.1f}", st.probeMs) + " ms, " +
+                                      std::format("{:.2f}", 100.0 * st.probePixels / framePixels) + "% px)"
+                                    : std::to_string(g_state.maxIter));
+            if (st.frame != g_state.requestedFrame)
+                view += "  Rendering ...";
+            const std::string kernel = "Kernel: " + (st.perturbation
+                                    ? "Perturbation (ref " + std::to_string(st.referenceIterations) + " iters, " +
+                                      std::format("{:.1f}", st.referenceMs) + " ms, series skip " +
+                                      std::to_string(st.seriesIterations) + " = " +
+                                      std::format("{:.3g}", (double)st.seriesIterations * st.computedPixels) + " iters saved, BLA " +
+                                      std::to_string(st.blaLevels) + " levels " + std::format("{:.1f}", st.blaMs) + " ms, " +
+                                      std::to_string(1 + st.glitches.references) + " refs, " +
+                                      std::to_string(st.glitches.rerendered) + " px re-rendered)"
+                                    : std::string(KernelIsaName(g_state.kernelIsa)) + " " + KernelPrecisionName(st.lanePrecision)) +
+                                (st.distance ? " + DE" : "") +
+                                "  Threads: " + std::to_string(g_renderPool->WorkerCount());
+            std::string timing = "Time: " + std::format("{:.1f}", st.renderMs) + " ms (iterate " + std::format("{:.1f}", st.iterationMs) +
+                                (g_state.histogramColoring ? ", histogram " + std::format("{:.1f}", st.histogramMs) : std::string()) +
+                                ", color " + std::format("{:.1f}", st.colorMs) + " = " +
+                                std::format("{:.2f}", st.colorMs * 1e6 / (std::max)(1ll, st.coloredPixels)) + " ms/MP)" +
+                                "  Skipped: " + std::format("{:.1f}", 100.0 * st.skippedPixels / framePixels) + "%";
+            if (g_state.renderMode == RenderMode::MarianiSilver)
+            {
+                double computedPct = 100.0 * st.computedPixels / framePixels;
+                timing += "  Computed: " + std::format("{:.1f}", computedPct) + "%  Filled: " + std::format("{:.1f}", 100.0 - computedPct) + "%";
+            }
+            else if (g_state.renderMode == RenderMode::Progressive)
+            {
+                timing += "  First pass: " + std::format("{:.1f}", st.firstPassMs) + " ms" +
+                          "  Guessed: " + std::format("{:.1f}", 100.0 * st.guessedPixels / framePixels) + "%";
+            }
+            std::string reuse;
+            if (st.reusedPixels > 0)
+                reuse += "  Reused: " + std::format("{:.1f}", 100.0 * st.reusedPixels / framePixels) + "%";
+            if (g_state.tileCache)
+                reuse += "  Cache: " + (st.cacheTiles
+                             ? std::format("{:.1f}", 100.0 * st.cacheHits / st.cacheTiles) + "% of " + std::to_string(st.cacheTiles) + " tiles"
+                             : std::string("off grid")) +
+                         ", " + std::format("{:.1f}", st.cacheBytes / 1048576.0) + " / " + std::to_string(g_state.tileCacheMB) + " MB";
+            if (st.aaSamples)
+                reuse += "  AA: " + std::format("{:.2f}", 100.0 * st.supersampledPixels / framePixels) + "% px at " +
+                         std::to_string(st.aaSamples) + "x" + std::to_string(st.aaSamples) + ", " +
+                         std::format("{:.1f}", st.aaMs) + " ms";
+            if (!reuse.empty())
+                reuse.erase(0, 2); // the leading separator
+
             SetTextColor(hdc, RGB(255, 255, 255));
             SetBkMode(hdc, TRANSPARENT);
-            RECT r = { 8, 8, g_state.width - 8, 40 };
-            DrawTextA(hdc, info.c_str(), static_cast<int>(info.size()), &r, DT_LEFT | DT_SINGLELINE | DT_NOPREFIX);
+            int top = 8;
+            const std::string* lines[] = { &view, &kernel, &timing, &reuse };
+            for (const std::string* line : lines)
+            {
+                if (line->empty())
+                    continue;
+                RECT r = { 8, top, g_state.width - 8, top };
+                const UINT format = DT_LEFT | DT_WORDBREAK | DT_NOPREFIX;
+                DrawTextA(hdc, line->c_str(), static_cast<int>(line->size()), &r, format | DT_CALCRECT);
+                DrawTextA(hdc, line->c_str(), static_cast<int>(line->size()), &r, format);
+                top = r.bottom;
+            }
         }
 
         // Draw selection rectangle overlay if any
@@ -572,12 +1621,15 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_FRAME_READY:
+    {
+        PresentFrame(hwnd);
+        return 0;
+    }
+
     case WM_DESTROY:
     {
-        if (g_state.hBitmap) DeleteObject(g_state.hBitmap);
-        g_state.hBitmap = nullptr;
-        g_state.pixels = nullptr;
-        g_state.pitch = 0;
+        StopRenderThread();
         PostQuitMessage(0);
         return 0;
     }
@@ -586,8 +1638,105 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     return DefWindowProc(hwnd, msg, wParam, lParam);
 }
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
+// Selects the escape-time kernel: the widest the CPU supports, unless --kernel=<name> asks
+// for a narrower one. Requests the CPU cannot run fall back to the detected kernel.
+static void SelectKernel(LPSTR cmdLine)
 {
+    const KernelIsa detected = DetectKernelIsa();
+    g_state.kernelIsa = detected;
+
+    const char* flag = cmdLine ? strstr(cmdLine, "--kernel=") : nullptr;
+    if (!flag) return;
+
+    KernelIsa requested;
+    if (!ParseKernelIsa(flag + strlen("--kernel="), requested))
+    {
+        MessageBoxA(NULL, "Unknown --kernel value (expected scalar, sse2, avx2 or avx512)", "Mandelbrot", MB_ICONERROR);
+        return;
+    }
+    if (requested > detected)
+    {
+        std::string msg = std::string("This CPU does not support the ") + KernelIsaName(requested) +
+                          " kernel; using " + KernelIsaName(detected) + ".";
+        MessageBoxA(NULL, msg.c_str(), "Mandelbrot", MB_ICONERROR);
+        return;
+    }
+    g_state.kernelIsa = requested;
+}
+
+static void SelectPrecision(LPSTR cmdLine)
+{
+    const char* flag = cmdLine ? strstr(cmdLine, "--precision=") : nullptr;
+    if (!flag) return;
+
+    if (!ParseKernelPrecision(flag + strlen("--precision="), g_state.precision))
+        MessageBoxA(NULL, "Unknown --precision value (expected auto, float, double or dd)", "Mandelbrot", MB_ICONERROR);
+}
+
+static void SelectRebase(LPSTR cmdLine)
+{
+    if (cmdLine && strstr(cmdLine, "--no-rebase"))
+        g_state.rebase = false;
+}
+
+static void SelectAntialiasing(LPSTR cmdLine)
+{
+    const char* flag = cmdLine ? strstr(cmdLine, "--aa=") : nullptr;
+    if (!flag) return;
+
+    const int samples = atoi(flag + strlen("--aa="));
+    if (samples < 2 || samples > kMaxSamples)
+    {
+        MessageBoxA(NULL, "Unknown --aa value (expected 2 to 8 samples per axis)", "Mandelbrot", MB_ICONERROR);
+        return;
+    }
+    g_state.aaSamples = samples;
+    g_state.antialias = true;
+}
+
+static void SelectTileCache(LPSTR cmdLine)
+{
+    const char* flag = cmdLine ? strstr(cmdLine, "--tile-cache=") : nullptr;
+    if (!flag) return;
+
+    const int megabytes = atoi(flag + strlen("--tile-cache="));
+    if (megabytes < 1)
+    {
+        MessageBoxA(NULL, "Unknown --tile-cache value (expected a memory budget in MB)", "Mandelbrot", MB_ICONERROR);
+        return;
+    }
+    g_state.tileCacheMB = megabytes;
+    g_state.tileCache = true;
+}
+
+static void SelectPalette(LPSTR cmdLine)
+{
+    const char* flag = cmdLine ? strstr(cmdLine, "--palette=") : nullptr;
+    if (!flag) return;
+
+    const char* path = flag + strlen("--palette=");
+    std::string file;
+    if (*path == '"')
+        file.assign(path + 1, strcspn(path + 1, "\""));
+    else
+        file.assign(path, strcspn(path, " \t"));
+    LoadPalette(file.c_str());
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow)
+{
+    SelectKernel(lpCmdLine);
+    SelectPrecision(lpCmdLine);
+    SelectRebase(lpCmdLine);
+    SelectPalette(lpCmdLine);
+    SelectAntialiasing(lpCmdLine);
+    SelectTileCache(lpCmdLine);
+
+    // Render workers live for the whole session; frames only hand them tiles. The render
+    // thread drives them so the message loop never waits for a frame.
+    g_renderPool = std::make_unique<ThreadPool>();
+    StartRenderThread();
+
     // Use Unicode window class and CreateWindowExW to ensure the caption is set correctly
     WNDCLASSEXW wc = { 0 };
     wc.cbSize = sizeof(wc);
@@ -611,13 +1760,28 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
         HMENU hFile = CreatePopupMenu();
         AppendMenuW(hFile, MF_STRING, ID_VIEW_RESET, L"&Reset\tR");
         AppendMenuW(hFile, MF_STRING, IDM_PROPERTIES, L"&Properties");
+        AppendMenuW(hFile, MF_STRING, ID_FILE_LOAD_PALETTE, L"Load P&alette...");
+        AppendMenuW(hFile, MF_STRING, ID_FILE_DEFAULT_PALETTE, L"&Default Palette");
         AppendMenuW(hFile, MF_SEPARATOR, 0, NULL);
         AppendMenuW(hFile, MF_STRING, ID_FILE_EXIT, L"E&xit\tEsc");
         AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hFile, L"&File");
 
         HMENU hView = CreatePopupMenu();
+        AppendMenuW(hView, MF_STRING, ID_VIEW_ZOOM_OUT, L"&Zoom Out x2\tZ");
+        AppendMenuW(hView, MF_STRING, ID_VIEW_SMOOTH, L"&Smooth Coloring\tS");
+        AppendMenuW(hView, MF_STRING, ID_VIEW_HISTOGRAM, L"&Histogram Coloring\tH");
+        AppendMenuW(hView, MF_STRING | (g_state.antialias ? MF_CHECKED : 0), ID_VIEW_ANTIALIAS, L"A&ntialiasing\tN");
+        AppendMenuW(hView, MF_STRING, ID_VIEW_DISTANCE, L"&Distance Estimation\tD");
+        AppendMenuW(hView, MF_STRING | (g_state.tileCache ? MF_CHECKED : 0), ID_VIEW_TILE_CACHE, L"&Tile Cache\tT");
+        AppendMenuW(hView, MF_SEPARATOR, 0, NULL);
         AppendMenuW(hView, MF_STRING, ID_ITER_INC, L"Increase Iterations\t+");
         AppendMenuW(hView, MF_STRING, ID_ITER_DEC, L"Decrease Iterations\t-");
+        AppendMenuW(hView, MF_STRING, ID_VIEW_AUTO_ITER, L"&Automatic Iterations\tA");
+        AppendMenuW(hView, MF_SEPARATOR, 0, NULL);
+        AppendMenuW(hView, MF_STRING, ID_MODE_BRUTE, L"&Brute Force");
+        AppendMenuW(hView, MF_STRING, ID_MODE_MARIANI, L"&Mariani-Silver");
+        AppendMenuW(hView, MF_STRING, ID_MODE_PROGRESSIVE, L"&Progressive");
+        CheckMenuRadioItem(hView, ID_MODE_BRUTE, ID_MODE_PROGRESSIVE, ID_MODE_BRUTE, MF_BYCOMMAND);
         AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hView, L"&View");
 
         HMENU hHelp = CreatePopupMenu();
@@ -649,10 +1813,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     ShowWindow(hwnd, nCmdShow);
     UpdateWindow(hwnd);
 
-    // Create initial bitmap sized to client area (redundant with WM_CREATE but ensures correct size)
+    // Size the view to the client area (redundant with WM_CREATE but ensures correct size)
     RECT client;
     GetClientRect(hwnd, &client);
-    CreateOrResizeBitmap(client.right - client.left, client.bottom - client.top);
+    ResizeView(client.right - client.left, client.bottom - client.top);
 
     // Main loop
     MSG msg;
@@ -665,5 +1829,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     // Clean up menu we created
     if (hMenu) DestroyMenu(hMenu);
 
+    StopRenderThread();
+    g_renderPool.reset();
+
     return (int)msg.wParam;
 }
\ No newline at end of file
@@ -0,0 +1,344 @@
+#pragma once
+
+// Escape-time loop shared by every kernel. Each instruction set provides a "pack" type
+// describing its lanes; the loop below is written once against that interface so the
+// arithmetic (and therefore every iteration count) is the same in all of them.
+//
+// Packs exist for double and float lanes; the float ones are only used when the view is
+// shallow enough for single precision (see FloatPrecisionSuffices).
+//
+// A pack provides:
+//   V, M, C, Lanes      - lane vector (double or float), lane mask, lane counters, lane count
+//   Epsilon             - machine epsilon of the lane type
+//   Set1, LaneIndex     - broadcast (converting from double), and { 0, 1, 2, ... }
+//   Add, Sub, Mul, Abs  - lane-wise arithmetic (never fused)
+//   CmpLE, Any, Bits    - lane mask of a <= b, whether any lane is set, lane bits as an integer
+//   And, Or, AndNot(a, b) - mask a & b, a | b, and a & ~b
+//   Select(m, a, b)     - a where m is set, b elsewhere
+//   ZeroCount, CountActive(c, m) - zeroed counters, and c + 1 in lanes where m is set
+//   SetCount(c, m, v)   - c with lanes where m is set replaced by v
+//   StoreCounts(c, out, n) - first n lane counters as int
+//   StoreNorms(v, out, n)  - first n lanes as float
+//
+// Double packs also provide ProductError(a, b, p), the exact a * b - p for p = Mul(a, b),
+// which IterateRowDoubleDouble builds its arithmetic on: one fused multiply-subtract where
+// the instruction set has FMA, DekkerProductError otherwise.
+
+#include "MandelbrotKernels.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Periodicity check tolerance in lane epsilons of |z|: an orbit that returns to an earlier
+// point to within rounding has settled on an attracting cycle and is interior. Anything
+// looser (a fraction of a pixel, say) also catches escaping orbits that linger near a weakly
+// repelling cycle at component boundaries, which then differ from the plain loop.
+const double kPeriodicityUlps = 4.0;
+
+inline int CountLaneBits(unsigned bits)
+{
+    int n = 0;
+    for (; bits; bits &= bits - 1) ++n;
+    return n;
+}
+
+// Exterior distance estimate |z| ln|z| / |dz/dc| from |z|^2 and |dz/dc|^2 at escape, in the
+// units of c that dz/dc is taken in; the distance to the set lies between half and twice it.
+// ln|z| comes from the float's exponent and a linear mantissa (log2 error below 0.09, against log2 |z|^2 > 2 at
+// escape), which is plenty for a bound that loose. A derivative that overflowed gives 0.
+inline float DistanceEstimate(float z2, float dz2)
+{
+    uint32_t bits;
+    memcpy(&bits, &z2, sizeof(bits));
+    const float log2z2 = (float)bits * (1.0f / (1 << 23)) - 127.0f;
+    const float d = sqrtf(z2 / dz2) * (0.5f * 0.693147181f) * log2z2;
+    return d >= 0.0f ? d : 0.0f;
+}
+
+// Stores the distance estimates of the first n lanes into out, in the units of c, 0 for
+// interior lanes. |dz/dc| grows like the inverse of the distance, so its square overflows a
+// float from about 1e-19 per pixel on: dz/dc is taken to pixels (times the pixel spacing)
+// in lane precision first, and the estimate in pixels back to the units of c in double.
+template <class Pack>
+inline void StoreDistances(typename Pack::V z2, typename Pack::V dzx, typename Pack::V dzy, double scale,
+                           const int* iters, int maxIter, float* out, int n)
+{
+    const typename Pack::V pixel = Pack::Set1(scale);
+    const typename Pack::V px = Pack::Mul(dzx, pixel), py = Pack::Mul(dzy, pixel);
+    float zs[16], dzs[16];
+    Pack::StoreNorms(z2, zs, n);
+    Pack::StoreNorms(Pack::Add(Pack::Mul(px, px), Pack::Mul(py, py)), dzs, n);
+    for (int k = 0; k < n; ++k)
+        out[k] = iters[k] < maxIter ? (float)(DistanceEstimate(zs[k], dzs[k]) * scale) : 0.0f;
+}
+
+// With Distance set, the loop also carries dz/dc (dz_{n+1} = 2 z_n dz_n + 1) beside z and
+// stores DistanceEstimate in norms instead of |z|^2. Counts are the same either way.
+template <class Pack, bool Distance = false>
+inline int IterateRowPacked(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    typedef typename Pack::V V;
+    typedef typename Pack::M M;
+    typedef typename Pack::C C;
+
+    const V four = Pack::Set1(4.0);
+    const V two = Pack::Set1(2.0);
+    const V one = Pack::Set1(1.0);
+    const V quarter = Pack::Set1(0.25);
+    const V sixteenth = Pack::Set1(0.0625);
+    const V cx = Pack::Set1(p.cx);
+    const V halfW = Pack::Set1(p.halfW);
+    const V scale = Pack::Set1(p.scale);
+    const V imag = Pack::Set1(p.imag);
+    const V laneOffset = Pack::Mul(Pack::LaneIndex(), Pack::Set1(p.stride));
+    const V imag2 = Pack::Mul(imag, imag);
+    const V epsilon = Pack::Set1(kPeriodicityUlps * Pack::Epsilon);
+    const int maxIter = p.maxIter;
+    int skipped = 0;
+
+    for (int i = 0; i < count; i += Pack::Lanes)
+    {
+        V px = Pack::Add(Pack::Set1(static_cast<double>(x0 + i * p.stride)), laneOffset);
+        V real = Pack::Add(cx, Pack::Mul(Pack::Sub(px, halfW), scale));
+
+        // Points in the main cardioid or the period-2 bulb never escape; mark them interior
+        // in closed form instead of running them to maxIter.
+        //   cardioid: q (q + (x - 1/4)) <= y^2 / 4   with q = (x - 1/4)^2 + y^2
+        //   bulb:     (x + 1)^2 + y^2 <= 1/16
+        V xq = Pack::Sub(real, quarter);
+        V q = Pack::Add(Pack::Mul(xq, xq), imag2);
+        M inCardioid = Pack::CmpLE(Pack::Mul(q, Pack::Add(q, xq)), Pack::Mul(quarter, imag2));
+        V xb = Pack::Add(real, one);
+        M inBulb = Pack::CmpLE(Pack::Add(Pack::Mul(xb, xb), imag2), sixteenth);
+        const M closedForm = Pack::Or(inCardioid, inBulb);
+        M interior = closedForm;
+
+        V zx = Pack::Set1(0.0), zy = Pack::Set1(0.0);
+        V zx2 = Pack::Set1(0.0), zy2 = Pack::Set1(0.0);
+        V dzx = zx, dzy = zy;
+        C laneIter = Pack::ZeroCount();
+
+        // Brent-style cycle detection: z is saved whenever the iteration count reaches a power
+        // of two, so cycles of any period up to the current save interval are found. All lanes
+        // share the iteration index, so one save schedule serves the whole pack.
+        V savedX = zx, savedY = zy;
+        int nextSave = 1;
+
+        for (int iter = 0; iter < maxIter; ++iter)
+        {
+            // A lane stays active while |z|^2 <= 4; escaped lanes keep their last z and count.
+            M active = Pack::AndNot(Pack::CmpLE(Pack::Add(zx2, zy2), four), interior);
+            if (!Pack::Any(active))
+                break;
+
+            // The derivative chain reads z but does not feed it, so it overlaps the z update.
+            if constexpr (Distance)
+            {
+                V ndx = Pack::Add(Pack::Mul(two, Pack::Sub(Pack::Mul(zx, dzx), Pack::Mul(zy, dzy))), one);
+                V ndy = Pack::Mul(two, Pack::Add(Pack::Mul(zx, dzy), Pack::Mul(zy, dzx)));
+                dzx = Pack::Select(active, ndx, dzx);
+                dzy = Pack::Select(active, ndy, dzy);
+            }
+
+            V nzy = Pack::Add(Pack::Mul(Pack::Mul(two, zx), zy), imag);
+            V nzx = Pack::Add(Pack::Sub(zx2, zy2), real);
+            zy = Pack::Select(active, nzy, zy);
+            zx = Pack::Select(active, nzx, zx);
+            zx2 = Pack::Mul(zx, zx);
+            zy2 = Pack::Mul(zy, zy);
+            laneIter = Pack::CountActive(laneIter, active);
+
+            const V tolerance = Pack::Mul(epsilon, Pack::Add(Pack::Abs(zx), Pack::Abs(zy)));
+            M cycled = Pack::And(Pack::CmpLE(Pack::Abs(Pack::Sub(zx, savedX)), tolerance),
+                                 Pack::CmpLE(Pack::Abs(Pack::Sub(zy, savedY)), tolerance));
+            interior = Pack::Or(interior, Pack::And(active, cycled));
+
+            if (iter + 1 == nextSave)
+            {
+                savedX = zx;
+                savedY = zy;
+                nextSave *= 2;
+            }
+        }
+
+        laneIter = Pack::SetCount(laneIter, interior, maxIter);
+
+        // Lanes past the end of the row computed throw-away pixels; only store the real ones.
+        int n = count - i;
+        if (n > Pack::Lanes) n = Pack::Lanes;
+        Pack::StoreCounts(laneIter, iters + i, n);
+        if constexpr (Distance)
+            StoreDistances<Pack>(Pack::Add(zx2, zy2), dzx, dzy, p.scale, iters + i, maxIter, norms + i, n);
+        else
+            Pack::StoreNorms(Pack::Add(zx2, zy2), norms + i, n);
+        skipped += CountLaneBits(Pack::Bits(closedForm) & ((1u << n) - 1));
+    }
+    return skipped;
+}
+
+// Exact a * b - p without FMA (Dekker): a and b are split into 26-bit halves whose partial
+// products are exact in double. Needs the products computed without contraction, like the
+// rest of this file.
+template <class Pack>
+inline typename Pack::V DekkerProductError(typename Pack::V a, typename Pack::V b, typename Pack::V p)
+{
+    typedef typename Pack::V V;
+    const V splitter = Pack::Set1(134217729.0); // 2^27 + 1
+    V ta = Pack::Mul(splitter, a);
+    V aHi = Pack::Sub(ta, Pack::Sub(ta, a));
+    V aLo = Pack::Sub(a, aHi);
+    V tb = Pack::Mul(splitter, b);
+    V bHi = Pack::Sub(tb, Pack::Sub(tb, b));
+    V bLo = Pack::Sub(b, bHi);
+    V err = Pack::Sub(Pack::Mul(aHi, bHi), p);
+    err = Pack::Add(err, Pack::Mul(aHi, bLo));
+    err = Pack::Add(err, Pack::Mul(aLo, bHi));
+    return Pack::Add(err, Pack::Mul(aLo, bLo));
+}
+
+// Double-double lanes: value = hi + lo with |lo| <= ulp(hi) / 2, about 106 bits.
+template <class Pack>
+struct DoubleDouble
+{
+    typedef typename Pack::V V;
+    V hi, lo;
+
+    // hi + lo for |a| >= |b| (or a == 0), renormalized.
+    static DoubleDouble QuickTwoSum(V a, V b)
+    {
+        V s = Pack::Add(a, b);
+        return { s, Pack::Sub(b, Pack::Sub(s, a)) };
+    }
+
+    static DoubleDouble Add(const DoubleDouble& x, const DoubleDouble& y)
+    {
+        V s = Pack::Add(x.hi, y.hi);
+        V bb = Pack::Sub(s, x.hi);
+        V e = Pack::Add(Pack::Sub(x.hi, Pack::Sub(s, bb)), Pack::Sub(y.hi, bb));
+        e = Pack::Add(e, Pack::Add(x.lo, y.lo));
+        return QuickTwoSum(s, e);
+    }
+
+    static DoubleDouble Neg(const DoubleDouble& x)
+    {
+        const V zero = Pack::Set1(0.0);
+        return { Pack::Sub(zero, x.hi), Pack::Sub(zero, x.lo) };
+    }
+
+    static DoubleDouble Mul(const DoubleDouble& x, const DoubleDouble& y)
+    {
+        V p = Pack::Mul(x.hi, y.hi);
+        V e = Pack::ProductError(x.hi, y.hi, p);
+        e = Pack::Add(e, Pack::Add(Pack::Mul(x.hi, y.lo), Pack::Mul(x.lo, y.hi)));
+        return QuickTwoSum(p, e);
+    }
+
+    static DoubleDouble Square(const DoubleDouble& x)
+    {
+        V p = Pack::Mul(x.hi, x.hi);
+        V e = Pack::ProductError(x.hi, x.hi, p);
+        e = Pack::Add(e, Pack::Mul(Pack::Add(x.hi, x.hi), x.lo));
+        return QuickTwoSum(p, e);
+    }
+
+    static DoubleDouble Twice(const DoubleDouble& x)
+    {
+        return { Pack::Add(x.hi, x.hi), Pack::Add(x.lo, x.lo) };
+    }
+
+    static DoubleDouble Select(typename Pack::M m, const DoubleDouble& a, const DoubleDouble& b)
+    {
+        return { Pack::Select(m, a.hi, b.hi), Pack::Select(m, a.lo, b.lo) };
+    }
+};
+
+// Same escape-time loop in double-double, for views between double's limit and the depth
+// where perturbation takes over (see DoubleDoublePrecisionSuffices). The row coordinate is
+// p.cx + p.cxLo and p.imag + p.imagLo. The cardioid/bulb shortcut is left out: at these
+// depths a view either lies wholly inside them or its pixels sit on the boundary, where the
+// closed-form test in double cannot decide. With Distance set, dz/dc is carried in plain
+// double from the high parts of z, which is all a distance estimate needs.
+template <class Pack, bool Distance = false>
+inline int IterateRowDoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    typedef typename Pack::V V;
+    typedef typename Pack::M M;
+    typedef typename Pack::C C;
+    typedef DoubleDouble<Pack> DD;
+
+    const V zero = Pack::Set1(0.0);
+    const V one = Pack::Set1(1.0);
+    const V two = Pack::Set1(2.0);
+    const V four = Pack::Set1(4.0);
+    const DD cx = DD::QuickTwoSum(Pack::Set1(p.cx), Pack::Set1(p.cxLo));
+    const DD imag = DD::QuickTwoSum(Pack::Set1(p.imag), Pack::Set1(p.imagLo));
+    const V halfW = Pack::Set1(p.halfW);
+    const V scale = Pack::Set1(p.scale);
+    const V laneOffset = Pack::Mul(Pack::LaneIndex(), Pack::Set1(p.stride));
+    const V epsilon = Pack::Set1(kPeriodicityUlps * Pack::Epsilon * Pack::Epsilon); // about 2^-104
+    const int maxIter = p.maxIter;
+
+    for (int i = 0; i < count; i += Pack::Lanes)
+    {
+        // The offset from cx is a double like in the other kernels; only the sum needs 106 bits.
+        V px = Pack::Add(Pack::Set1(static_cast<double>(x0 + i * p.stride)), laneOffset);
+        const DD real = DD::Add(cx, DD{ Pack::Mul(Pack::Sub(px, halfW), scale), zero });
+
+        DD zx{ zero, zero }, zy{ zero, zero };
+        DD zx2{ zero, zero }, zy2{ zero, zero };
+        V dzx = zero, dzy = zero;
+        M interior = Pack::CmpLE(four, zero); // 4 <= 0: no lane set
+        C laneIter = Pack::ZeroCount();
+
+        DD savedX = zx, savedY = zy;
+        int nextSave = 1;
+
+        for (int iter = 0; iter < maxIter; ++iter)
+        {
+            M active = Pack::AndNot(Pack::CmpLE(Pack::Add(zx2.hi, zy2.hi), four), interior);
+            if (!Pack::Any(active))
+                break;
+
+            if constexpr (Distance)
+            {
+                V ndx = Pack::Add(Pack::Mul(two, Pack::Sub(Pack::Mul(zx.hi, dzx), Pack::Mul(zy.hi, dzy))), one);
+                V ndy = Pack::Mul(two, Pack::Add(Pack::Mul(zx.hi, dzy), Pack::Mul(zy.hi, dzx)));
+                dzx = Pack::Select(active, ndx, dzx);
+                dzy = Pack::Select(active, ndy, dzy);
+            }
+
+            DD nzy = DD::Add(DD::Twice(DD::Mul(zx, zy)), imag);
+            DD nzx = DD::Add(DD::Add(zx2, DD::Neg(zy2)), real);
+            zy = DD::Select(active, nzy, zy);
+            zx = DD::Select(active, nzx, zx);
+            zx2 = DD::Square(zx);
+            zy2 = DD::Square(zy);
+            laneIter = Pack::CountActive(laneIter, active);
+
+            DD dx = DD::Add(zx, DD::Neg(savedX));
+            DD dy = DD::Add(zy, DD::Neg(savedY));
+            const V tolerance = Pack::Mul(epsilon, Pack::Add(Pack::Abs(zx.hi), Pack::Abs(zy.hi)));
+            M cycled = Pack::And(Pack::CmpLE(Pack::Abs(dx.hi), tolerance), Pack::CmpLE(Pack::Abs(dy.hi), tolerance));
+            interior = Pack::Or(interior, Pack::And(active, cycled));
+
+            if (iter + 1 == nextSave)
+            {
+                savedX = zx;
+                savedY = zy;
+                nextSave *= 2;
+            }
+        }
+
+        laneIter = Pack::SetCount(laneIter, interior, maxIter);
+
+        int n = count - i;
+        if (n > Pack::Lanes) n = Pack::Lanes;
+        Pack::StoreCounts(laneIter, iters + i, n);
+        if constexpr (Distance)
+            StoreDistances<Pack>(Pack::Add(zx2.hi, zy2.hi), dzx, dzy, p.scale, iters + i, maxIter, norms + i, n);
+        else
+            Pack::StoreNorms(Pack::Add(zx2.hi, zy2.hi), norms + i, n);
+    }
+    return 0;
+}
@@ -0,0 +1,332 @@
+// Escape-time kernels used by RenderMandelbrot: scalar path, CPU detection and dispatch.
+//
+// The vector kernels live in MandelbrotKernelsSSE2.cpp / AVX2.cpp / AVX512.cpp so each can be
+// compiled for its own instruction set. All of them instantiate IterateRowPacked (see
+// MandelbrotKernelLoop.h) and evaluate the recurrence with the same operations in the same
+// order (no FMA contraction in the z update), so they return exactly the scalar counts.
+
+#include "MandelbrotKernelLoop.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <strings.h>
+#endif
+
+namespace
+{
+    struct ScalarPack
+    {
+        typedef double V;
+        typedef bool M;
+        typedef V C;
+        static const int Lanes = 1;
+        static constexpr double Epsilon = DBL_EPSILON;
+
+        static V Set1(double v) { return v; }
+        static V LaneIndex() { return 0.0; }
+        static V Add(V a, V b) { return a + b; }
+        static V Sub(V a, V b) { return a - b; }
+        static V Mul(V a, V b) { return a * b; }
+        static V ProductError(V a, V b, V p) { return DekkerProductError<ScalarPack>(a, b, p); }
+        static V Abs(V a) { return a < 0 ? -a : a; }
+        static M CmpLE(V a, V b) { return a <= b; }
+        static bool Any(M m) { return m; }
+        static unsigned Bits(M m) { return m ? 1u : 0u; }
+        static M And(M a, M b) { return a && b; }
+        static M Or(M a, M b) { return a || b; }
+        static M AndNot(M a, M b) { return a && !b; }
+        static V Select(M m, V a, V b) { return m ? a : b; }
+        static C ZeroCount() { return Set1(0.0); }
+        static C CountActive(C c, M m) { return m ? c + 1.0 : c; }
+        static C SetCount(C c, M m, int v) { return m ? static_cast<double>(v) : c; }
+        static void StoreCounts(C c, int* out, int) { *out = static_cast<int>(c); }
+        static void StoreNorms(V v, float* out, int) { *out = static_cast<float>(v); }
+    };
+
+    struct ScalarFloatPack
+    {
+        typedef float V;
+        typedef bool M;
+        typedef int C;
+        static const int Lanes = 1;
+        static constexpr double Epsilon = FLT_EPSILON;
+
+        static V Set1(double v) { return static_cast<float>(v); }
+        static V LaneIndex() { return 0.0f; }
+        static V Add(V a, V b) { return a + b; }
+        static V Sub(V a, V b) { return a - b; }
+        static V Mul(V a, V b) { return a * b; }
+        static V Abs(V a) { return a < 0 ? -a : a; }
+        static M CmpLE(V a, V b) { return a <= b; }
+        static bool Any(M m) { return m; }
+        static unsigned Bits(M m) { return m ? 1u : 0u; }
+        static M And(M a, M b) { return a && b; }
+        static M Or(M a, M b) { return a || b; }
+        static M AndNot(M a, M b) { return a && !b; }
+        static V Select(M m, V a, V b) { return m ? a : b; }
+        static C ZeroCount() { return 0; }
+        static C CountActive(C c, M m) { return m ? c + 1 : c; }
+        static C SetCount(C c, M m, int v) { return m ? v : c; }
+        static void StoreCounts(C c, int* out, int) { *out = c; }
+        static void StoreNorms(V v, float* out, int) { *out = v; }
+    };
+
+    void CpuId(unsigned int leaf, unsigned int subLeaf, unsigned int regs[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(reinterpret_cast<int*>(regs), static_cast<int>(leaf), static_cast<int>(subLeaf));
+#else
+        __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    unsigned long long ReadXcr0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int lo = 0, hi = 0;
+        __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+    }
+}
+
+int IterateRowScalar(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<ScalarPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowScalarDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<ScalarPack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowScalarFloat(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<ScalarFloatPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowScalarFloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<ScalarFloatPack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowScalarDoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<ScalarPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowScalarDoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<ScalarPack, true>(p, x0, count, iters, norms);
+}
+
+KernelIsa DetectKernelIsa()
+{
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+
+    CpuId(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+
+    CpuId(1, 0, regs);
+    const unsigned int ecx1 = regs[2];
+    const unsigned int edx1 = regs[3];
+
+    if ((edx1 & (1u << 26)) == 0) // SSE2
+        return KernelIsa::Scalar;
+
+    // Wider kernels need the OS to save the extended register state (OSXSAVE + XCR0).
+    if ((ecx1 & (1u << 27)) == 0 || maxLeaf < 7)
+        return KernelIsa::SSE2;
+
+    const unsigned long long xcr0 = ReadXcr0();
+    const bool osYmm = (xcr0 & 0x06) == 0x06;           // XMM | YMM
+    const bool osZmm = (xcr0 & 0xE6) == 0xE6;           // ... | opmask | ZMM_Hi256 | Hi16_ZMM
+
+    CpuId(7, 0, regs);
+    const unsigned int ebx7 = regs[1];
+
+    const bool avx2 = (ebx7 & (1u << 5)) != 0 && (ecx1 & (1u << 12)) != 0; // AVX2 + FMA
+    // /arch:AVX512 lets the compiler use F, CD, BW, DQ and VL anywhere in
+    // MandelbrotKernelsAVX512.cpp (the 256-bit stores, for one), so an F-only CPU stays on AVX2.
+    const unsigned int avx512Bits = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31); // F DQ CD BW VL
+    const bool avx512 = (ebx7 & avx512Bits) == avx512Bits;
+
+    if (avx2 && avx512 && osZmm)
+        return KernelIsa::AVX512;
+    if (avx2 && osYmm)
+        return KernelIsa::AVX2;
+    return KernelIsa::SSE2;
+}
+
+RowKernel GetRowKernel(KernelIsa isa, KernelPrecision precision, bool distance)
+{
+    if (distance)
+    {
+        if (precision == KernelPrecision::Float)
+        {
+            switch (isa)
+            {
+            case KernelIsa::SSE2:   return IterateRowSSE2FloatDistance;
+            case KernelIsa::AVX2:   return IterateRowAVX2FloatDistance;
+            case KernelIsa::AVX512: return IterateRowAVX512FloatDistance;
+            default:                return IterateRowScalarFloatDistance;
+            }
+        }
+        if (precision == KernelPrecision::DoubleDouble)
+        {
+            switch (isa)
+            {
+            case KernelIsa::SSE2:   return IterateRowSSE2DoubleDoubleDistance;
+            case KernelIsa::AVX2:   return IterateRowAVX2DoubleDoubleDistance;
+            case KernelIsa::AVX512: return IterateRowAVX512DoubleDoubleDistance;
+            default:                return IterateRowScalarDoubleDoubleDistance;
+            }
+        }
+        switch (isa)
+        {
+        case KernelIsa::SSE2:   return IterateRowSSE2Distance;
+        case KernelIsa::AVX2:   return IterateRowAVX2Distance;
+        case KernelIsa::AVX512: return IterateRowAVX512Distance;
+        default:                return IterateRowScalarDistance;
+        }
+    }
+    if (precision == KernelPrecision::Float)
+    {
+        switch (isa)
+        {
+        case KernelIsa::SSE2:   return IterateRowSSE2Float;
+        case KernelIsa::AVX2:   return IterateRowAVX2Float;
+        case KernelIsa::AVX512: return IterateRowAVX512Float;
+        default:                return IterateRowScalarFloat;
+        }
+    }
+    if (precision == KernelPrecision::DoubleDouble)
+    {
+        switch (isa)
+        {
+        case KernelIsa::SSE2:   return IterateRowSSE2DoubleDouble;
+        case KernelIsa::AVX2:   return IterateRowAVX2DoubleDouble;
+        case KernelIsa::AVX512: return IterateRowAVX512DoubleDouble;
+        default:                return IterateRowScalarDoubleDouble;
+        }
+    }
+    switch (isa)
+    {
+    case KernelIsa::SSE2:   return IterateRowSSE2;
+    case KernelIsa::AVX2:   return IterateRowAVX2;
+    case KernelIsa::AVX512: return IterateRowAVX512;
+    default:                return IterateRowScalar;
+    }
+}
+
+// Required headroom between pixel spacing and lane resolution. At 1024x a float frame
+// differs from the double one on fewer (boundary) pixels than shifting the double frame
+// by 1/1000 of a pixel does, for maxIter up to 5000 - i.e. below sampling noise.
+static bool SpacingSuffices(double minX, double maxX, double minY, double maxY, double scale, double epsilon)
+{
+    const double kHeadroom = 1024.0;
+
+    double magnitude = 2.0; // orbits are iterated until |z| exceeds 2
+    magnitude = fmax(magnitude, fmax(fabs(minX), fabs(maxX)));
+    magnitude = fmax(magnitude, fmax(fabs(minY), fabs(maxY)));
+
+    return scale > kHeadroom * epsilon * magnitude;
+}
+
+bool FloatPrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale)
+{
+    return SpacingSuffices(minX, maxX, minY, maxY, scale, FLT_EPSILON);
+}
+
+bool DoublePrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale)
+{
+    return SpacingSuffices(minX, maxX, minY, maxY, scale, DBL_EPSILON);
+}
+
+bool DoubleDoublePrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale)
+{
+    return SpacingSuffices(minX, maxX, minY, maxY, scale, DBL_EPSILON * DBL_EPSILON); // 2^-104
+}
+
+const char* KernelIsaName(KernelIsa isa)
+{
+    switch (isa)
+    {
+    case KernelIsa::SSE2:   return "SSE2";
+    case KernelIsa::AVX2:   return "AVX2";
+    case KernelIsa::AVX512: return "AVX-512";
+    default:                return "Scalar";
+    }
+}
+
+const char* KernelPrecisionName(KernelPrecision precision)
+{
+    switch (precision)
+    {
+    case KernelPrecision::Float:        return "float";
+    case KernelPrecision::DoubleDouble: return "double-double";
+    case KernelPrecision::Auto:         return "auto";
+    default:                            return "double";
+    }
+}
+
+// Case-insensitive match of a whole word: the name followed by end of string or whitespace
+// (the text may come from the middle of a command line).
+static bool MatchWord(const char* text, const char* name)
+{
+    size_t len = strlen(name);
+#if defined(_MSC_VER)
+    bool match = _strnicmp(text, name, len) == 0;
+#else
+    bool match = strncasecmp(text, name, len) == 0;
+#endif
+    return match && (text[len] == '\0' || text[len] == ' ' || text[len] == '\t');
+}
+
+bool ParseKernelIsa(const char* text, KernelIsa& isa)
+{
+    static const struct { const char* name; KernelIsa isa; } names[] = {
+        { "scalar", KernelIsa::Scalar },
+        { "sse2",   KernelIsa::SSE2 },
+        { "avx2",   KernelIsa::AVX2 },
+        { "avx512", KernelIsa::AVX512 },
+    };
+
+    for (const auto& n : names)
+    {
+        if (MatchWord(text, n.name))
+        {
+            isa = n.isa;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseKernelPrecision(const char* text, KernelPrecision& precision)
+{
+    static const struct { const char* name; KernelPrecision precision; } names[] = {
+        { "auto",   KernelPrecision::Auto },
+        { "double", KernelPrecision::Double },
+        { "float",  KernelPrecision::Float },
+        { "dd",     KernelPrecision::DoubleDouble },
+    };
+
+    for (const auto& n : names)
+    {
+        if (MatchWord(text, n.name))
+        {
+            precision = n.precision;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+
+struct ReferenceOrbit;
+
+// Per-scanline inputs to the escape-time kernels. The real coordinate of pixel x is
+// cx + (x - halfW) * scale, evaluated with exactly the same operations as the scalar
+// loop so every kernel produces bit-identical iteration counts.
+struct RowParams
+{
+    double cx;
+    double halfW;
+    double scale;
+    double imag;
+    int maxIter;
+    const ReferenceOrbit* reference = nullptr; // perturbation only: cx/imag are offsets from it
+    double cxLo = 0.0, imagLo = 0.0;           // double-double only: low parts of cx and imag
+    int scaleExp = 0;                          // perturbation only: cx, imag and scale are in units of 2^scaleExp
+    bool rebase = true;                        // perturbation only: rebase when |z| < |dz| (see Perturbation.h)
+    int stride = 1;                            // distance between the row's pixels (progressive passes)
+};
+
+// Instruction set of the escape-time kernel, ordered from narrowest to widest.
+enum class KernelIsa
+{
+    Scalar,     // one pixel at a time
+    SSE2,       // 2 double lanes
+    AVX2,       // 4 double lanes
+    AVX512,     // 8 double lanes, k-mask registers freeze escaped lanes
+};
+
+// Writes the escape iteration count of the count pixels x0, x0 + stride, x0 + 2 stride, ... of
+// one row into iters[0 .. count), and |z|^2 of each pixel's last iterate into norms[0 .. count)
+// (above 4 for escaped pixels; smooth coloring uses it).
+// A count equal to maxIter means the point did not escape (interior). Pixels inside the main
+// cardioid or the period-2 bulb are marked interior without iterating; the return value is
+// how many were. Orbits caught in a cycle (periodicity check) stop early as interior too.
+typedef int (*RowKernel)(const RowParams& p, int x0, int count, int* iters, float* norms);
+
+int IterateRowScalar(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512(const RowParams& p, int x0, int count, int* iters, float* norms);
+
+// Single-precision variants: twice the lanes of the double kernels (1 / 4 / 8 / 16).
+// Only accurate while FloatPrecisionSuffices() holds for the view.
+int IterateRowScalarFloat(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2Float(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2Float(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512Float(const RowParams& p, int x0, int count, int* iters, float* norms);
+
+// Double-double variants (about 106 bits) for views past double precision: 1 / 2 / 4 / 8 lanes.
+// Exact products come from FMA on AVX2 and AVX-512, from Dekker splitting on scalar and SSE2.
+int IterateRowScalarDoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms);
+
+// Distance-estimation variants of all the above: the same counts, with the exterior distance
+// estimate of each escaped pixel (|z| ln|z| / |dz/dc| at escape, in world units; 0 for interior
+// pixels) stored in norms instead of |z|^2. They carry dz/dc beside z in the same loop.
+int IterateRowScalarDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2Distance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2Distance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512Distance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowScalarFloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowScalarDoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowSSE2DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX2DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+int IterateRowAVX512DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms);
+
+// Lane precision of the escape-time kernel.
+enum class KernelPrecision
+{
+    Auto,       // float while the pixel spacing allows it, then double, then double-double
+    Double,
+    Float,
+    DoubleDouble,
+};
+
+// Widest kernel the CPU and OS support (cpuid + xgetbv).
+KernelIsa DetectKernelIsa();
+
+// Kernel for the requested instruction set and lane type (Auto means Double), with distance
+// estimation if asked. Callers must not request more than DetectKernelIsa().
+RowKernel GetRowKernel(KernelIsa isa, KernelPrecision precision = KernelPrecision::Double, bool distance = false);
+
+// True when a view whose pixels span [minX, maxX] x [minY, maxY] at the given pixel spacing
+// can be iterated in float without visible difference: the spacing has to stay well above
+// float epsilon times the largest coordinate the orbit reaches (at least the escape radius).
+bool FloatPrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale);
+
+// Same test against double epsilon. Past it pixels collapse into blocks and the view needs
+// the double-double kernels.
+bool DoublePrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale);
+
+// Same test against double-double epsilon (2^-104). Past it the view needs the perturbation
+// engine (see Perturbation.h).
+bool DoubleDoublePrecisionSuffices(double minX, double maxX, double minY, double maxY, double scale);
+
+const char* KernelIsaName(KernelIsa isa);
+const char* KernelPrecisionName(KernelPrecision precision);
+
+// Parses "scalar", "sse2", "avx2" or "avx512" (case-insensitive). Returns false for anything else.
+bool ParseKernelIsa(const char* text, KernelIsa& isa);
+
+// Parses "auto", "double", "float" or "dd" (double-double; case-insensitive). Returns false for anything else.
+bool ParseKernelPrecision(const char* text, KernelPrecision& precision);
@@ -0,0 +1,121 @@
+// AVX2 kernels: 4 double lanes or 8 float lanes; the double-double kernel gets its exact
+// products from FMA. Compile this file with /arch:AVX2; it is only called after
+// DetectKernelIsa() has confirmed AVX2 + FMA support.
+
+#include "MandelbrotKernelLoop.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX2Pack
+    {
+        typedef __m256d V;
+        typedef __m256d M;
+        typedef V C;
+        static const int Lanes = 4;
+        static constexpr double Epsilon = DBL_EPSILON;
+
+        static V Set1(double v) { return _mm256_set1_pd(v); }
+        static V LaneIndex() { return _mm256_set_pd(3.0, 2.0, 1.0, 0.0); }
+        static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+        static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+        static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        static V ProductError(V a, V b, V p) { return _mm256_fmsub_pd(a, b, p); }
+        static V Abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+        static M CmpLE(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+        static bool Any(M m) { return _mm256_movemask_pd(m) != 0; }
+        static unsigned Bits(M m) { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+        static M And(M a, M b) { return _mm256_and_pd(a, b); }
+        static M Or(M a, M b) { return _mm256_or_pd(a, b); }
+        static M AndNot(M a, M b) { return _mm256_andnot_pd(b, a); }
+        static V Select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+        static C ZeroCount() { return Set1(0.0); }
+        static C CountActive(C c, M m) { return _mm256_add_pd(c, _mm256_and_pd(m, _mm256_set1_pd(1.0))); }
+        static C SetCount(C c, M m, int v) { return _mm256_blendv_pd(c, _mm256_set1_pd(v), m); }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm256_cvtpd_epi32(c));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, _mm256_cvtpd_ps(v));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+
+    struct AVX2FloatPack
+    {
+        typedef __m256 V;
+        typedef __m256 M;
+        typedef __m256i C;
+        static const int Lanes = 8;
+        static constexpr double Epsilon = FLT_EPSILON;
+
+        static V Set1(double v) { return _mm256_set1_ps(static_cast<float>(v)); }
+        static V LaneIndex() { return _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f); }
+        static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V Abs(V a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static M CmpLE(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static bool Any(M m) { return _mm256_movemask_ps(m) != 0; }
+        static unsigned Bits(M m) { return static_cast<unsigned>(_mm256_movemask_ps(m)); }
+        static M And(M a, M b) { return _mm256_and_ps(a, b); }
+        static M Or(M a, M b) { return _mm256_or_ps(a, b); }
+        static M AndNot(M a, M b) { return _mm256_andnot_ps(b, a); }
+        static V Select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+        static C ZeroCount() { return _mm256_setzero_si256(); }
+        static C CountActive(C c, M m) { return _mm256_sub_epi32(c, _mm256_castps_si256(m)); } // active lanes are -1
+        static C SetCount(C c, M m, int v) { return _mm256_blendv_epi8(c, _mm256_set1_epi32(v), _mm256_castps_si256(m)); }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), c);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[8];
+            _mm256_storeu_ps(lanes, v);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+}
+
+int IterateRowAVX2(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX2Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX2Distance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX2Pack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX2Float(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX2FloatPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX2FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX2FloatPack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX2DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<AVX2Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX2DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<AVX2Pack, true>(p, x0, count, iters, norms);
+}
@@ -0,0 +1,128 @@
+// AVX-512F kernels: 8 double lanes or 16 float lanes (double-double uses FMA). Compile this
+// file with /arch:AVX512; it is only called after DetectKernelIsa() has confirmed AVX-512F
+// support and OS-saved ZMM/opmask state.
+//
+// Lane masks are k-mask registers: escaped lanes are frozen with masked moves and masked
+// counter adds instead of blends.
+
+#include "MandelbrotKernelLoop.h"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX512Pack
+    {
+        typedef __m512d V;
+        typedef __mmask8 M;
+        typedef V C;
+        static const int Lanes = 8;
+        static constexpr double Epsilon = DBL_EPSILON;
+
+        static V Set1(double v) { return _mm512_set1_pd(v); }
+        static V LaneIndex() { return _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0); }
+        static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+        static V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+        static V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+        static V ProductError(V a, V b, V p) { return _mm512_fmsub_pd(a, b, p); }
+        static V Abs(V a) { return _mm512_abs_pd(a); }
+        static M CmpLE(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+        static bool Any(M m) { return m != 0; }
+        static unsigned Bits(M m) { return m; }
+        static M And(M a, M b) { return static_cast<M>(a & b); }
+        static M Or(M a, M b) { return static_cast<M>(a | b); }
+        static M AndNot(M a, M b) { return static_cast<M>(a & ~b); }
+        static V Select(M m, V a, V b) { return _mm512_mask_mov_pd(b, m, a); }
+        static C ZeroCount() { return Set1(0.0); }
+        static C CountActive(C c, M m) { return _mm512_mask_add_pd(c, m, c, _mm512_set1_pd(1.0)); }
+        static C SetCount(C c, M m, int v) { return _mm512_mask_mov_pd(c, m, _mm512_set1_pd(v)); }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm512_cvtpd_epi32(c));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[8];
+            _mm256_storeu_ps(lanes, _mm512_cvtpd_ps(v));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+
+    struct AVX512FloatPack
+    {
+        typedef __m512 V;
+        typedef __mmask16 M;
+        typedef __m512i C;
+        static const int Lanes = 16;
+        static constexpr double Epsilon = FLT_EPSILON;
+
+        static V Set1(double v) { return _mm512_set1_ps(static_cast<float>(v)); }
+        static V LaneIndex()
+        {
+            return _mm512_set_ps(15.0f, 14.0f, 13.0f, 12.0f, 11.0f, 10.0f, 9.0f, 8.0f,
+                                 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+        }
+        static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+        static V Abs(V a) { return _mm512_abs_ps(a); }
+        static M CmpLE(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+        static bool Any(M m) { return m != 0; }
+        static unsigned Bits(M m) { return m; }
+        static M And(M a, M b) { return static_cast<M>(a & b); }
+        static M Or(M a, M b) { return static_cast<M>(a | b); }
+        static M AndNot(M a, M b) { return static_cast<M>(a & ~b); }
+        static V Select(M m, V a, V b) { return _mm512_mask_mov_ps(b, m, a); }
+        static C ZeroCount() { return _mm512_setzero_si512(); }
+        static C CountActive(C c, M m) { return _mm512_mask_add_epi32(c, m, c, _mm512_set1_epi32(1)); }
+        static C SetCount(C c, M m, int v) { return _mm512_mask_mov_epi32(c, m, _mm512_set1_epi32(v)); }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[16];
+            _mm512_storeu_si512(lanes, c);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[16];
+            _mm512_storeu_ps(lanes, v);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+}
+
+int IterateRowAVX512(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX512Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX512Distance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX512Pack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX512Float(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX512FloatPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX512FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<AVX512FloatPack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX512DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<AVX512Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowAVX512DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<AVX512Pack, true>(p, x0, count, iters, norms);
+}
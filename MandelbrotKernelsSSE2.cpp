@@ -0,0 +1,124 @@
+// SSE2 kernels: 2 double lanes or 4 float lanes.
+// SSE2 has no blend instruction, so lane selection is and/andnot/or.
+
+#include "MandelbrotKernelLoop.h"
+
+#include <emmintrin.h>
+
+namespace
+{
+    struct SSE2Pack
+    {
+        typedef __m128d V;
+        typedef __m128d M;
+        typedef V C;
+        static const int Lanes = 2;
+        static constexpr double Epsilon = DBL_EPSILON;
+
+        static V Set1(double v) { return _mm_set1_pd(v); }
+        static V LaneIndex() { return _mm_set_pd(1.0, 0.0); }
+        static V Add(V a, V b) { return _mm_add_pd(a, b); }
+        static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+        static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+        static V ProductError(V a, V b, V p) { return DekkerProductError<SSE2Pack>(a, b, p); }
+        static V Abs(V a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+        static M CmpLE(V a, V b) { return _mm_cmple_pd(a, b); }
+        static bool Any(M m) { return _mm_movemask_pd(m) != 0; }
+        static unsigned Bits(M m) { return static_cast<unsigned>(_mm_movemask_pd(m)); }
+        static M And(M a, M b) { return _mm_and_pd(a, b); }
+        static M Or(M a, M b) { return _mm_or_pd(a, b); }
+        static M AndNot(M a, M b) { return _mm_andnot_pd(b, a); }
+        static V Select(M m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+        static C ZeroCount() { return Set1(0.0); }
+        static C CountActive(C c, M m) { return _mm_add_pd(c, _mm_and_pd(m, _mm_set1_pd(1.0))); }
+        static C SetCount(C c, M m, int v) { return Select(m, _mm_set1_pd(v), c); }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvtpd_epi32(c));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, _mm_cvtpd_ps(v));
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+
+    struct SSE2FloatPack
+    {
+        typedef __m128 V;
+        typedef __m128 M;
+        typedef __m128i C;
+        static const int Lanes = 4;
+        static constexpr double Epsilon = FLT_EPSILON;
+
+        static V Set1(double v) { return _mm_set1_ps(static_cast<float>(v)); }
+        static V LaneIndex() { return _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f); }
+        static V Add(V a, V b) { return _mm_add_ps(a, b); }
+        static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V Abs(V a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static M CmpLE(V a, V b) { return _mm_cmple_ps(a, b); }
+        static bool Any(M m) { return _mm_movemask_ps(m) != 0; }
+        static unsigned Bits(M m) { return static_cast<unsigned>(_mm_movemask_ps(m)); }
+        static M And(M a, M b) { return _mm_and_ps(a, b); }
+        static M Or(M a, M b) { return _mm_or_ps(a, b); }
+        static M AndNot(M a, M b) { return _mm_andnot_ps(b, a); }
+        static V Select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        static C ZeroCount() { return _mm_setzero_si128(); }
+        static C CountActive(C c, M m) { return _mm_sub_epi32(c, _mm_castps_si128(m)); } // active lanes are -1
+        static C SetCount(C c, M m, int v)
+        {
+            __m128i mi = _mm_castps_si128(m);
+            return _mm_or_si128(_mm_and_si128(mi, _mm_set1_epi32(v)), _mm_andnot_si128(mi, c));
+        }
+
+        static void StoreCounts(C c, int* out, int n)
+        {
+            int lanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), c);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+
+        static void StoreNorms(V v, float* out, int n)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, v);
+            for (int i = 0; i < n; ++i) out[i] = lanes[i];
+        }
+    };
+}
+
+int IterateRowSSE2(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<SSE2Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowSSE2Distance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<SSE2Pack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowSSE2Float(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<SSE2FloatPack>(p, x0, count, iters, norms);
+}
+
+int IterateRowSSE2FloatDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowPacked<SSE2FloatPack, true>(p, x0, count, iters, norms);
+}
+
+int IterateRowSSE2DoubleDouble(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<SSE2Pack>(p, x0, count, iters, norms);
+}
+
+int IterateRowSSE2DoubleDoubleDistance(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    return IterateRowDoubleDouble<SSE2Pack, true>(p, x0, count, iters, norms);
+}
@@ -0,0 +1,240 @@
+#include "Palette.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+#include <float.h>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+
+namespace
+{
+    // memory order: B G R [A/0]
+    inline uint32_t Bgra(int r, int g, int b)
+    {
+        return (uint32_t)(uint8_t)b | ((uint32_t)(uint8_t)g << 8) | ((uint32_t)(uint8_t)r << 16);
+    }
+
+    // log2 of positive normal floats: the exponent plus a degree-4 polynomial in the mantissa
+    // m = 1 + t, fitted to log2(1 + t) on [0, 1) with a maximum error of about 1.0e-4.
+    inline __m128 FastLog2(__m128 x)
+    {
+        const __m128i bits = _mm_castps_si128(x);
+        const __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        const __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                                       _mm_set1_epi32(0x3f800000)));
+        const __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+        __m128 p = _mm_set1_ps(-0.0847651903f);
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.325589059f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.679940222f));
+        p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.43901405f));
+        return _mm_add_ps(exponent, _mm_mul_ps(p, t));
+    }
+
+    // Fractional part of the smooth count, 2 - log2(log2 norm), for norms above 4: in [-5, 1).
+    // The inner error is at most scaled by 1 / (2 ln 2) in the outer log2, so the sum stays
+    // below about 2.5e-4 iterations.
+    inline __m128 SmoothFraction(__m128 norm)
+    {
+        return _mm_sub_ps(_mm_set1_ps(2.0f), FastLog2(FastLog2(norm)));
+    }
+
+    // Four pixels of ColorizeSmoothRow.
+    inline void ColorizeSmooth4(const uint32_t* palette, int maxIter, const int* iters, const float* norms,
+                                uint32_t* out)
+    {
+        static_assert(kSmoothSteps == 16, "the entry index is computed with a shift");
+
+        // floor(f * steps) as a truncation of a positive number: f > -5 for every float norm.
+        const int bias = 8 * kSmoothSteps;
+        const __m128i count = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iters));
+        const __m128 f = SmoothFraction(_mm_loadu_ps(norms));
+        const __m128i step = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, _mm_set1_ps((float)kSmoothSteps)),
+                                                                       _mm_set1_ps((float)bias))),
+                                           _mm_set1_epi32(bias));
+        __m128i index = _mm_add_epi32(_mm_slli_epi32(count, 4), step);
+
+        // Escaped pixels stay within the escaped entries; the rest take the inside color.
+        const __m128i last = _mm_set1_epi32(maxIter * kSmoothSteps - 1);
+        const __m128i zero = _mm_setzero_si128();
+        index = _mm_andnot_si128(_mm_cmplt_epi32(index, zero), index);
+        const __m128i high = _mm_cmpgt_epi32(index, last);
+        index = _mm_or_si128(_mm_and_si128(high, last), _mm_andnot_si128(high, index));
+        const __m128i escaped = _mm_andnot_si128(_mm_cmplt_epi32(count, zero),
+                                                 _mm_cmplt_epi32(count, _mm_set1_epi32(maxIter)));
+        index = _mm_or_si128(_mm_and_si128(escaped, index), _mm_andnot_si128(escaped, _mm_add_epi32(last, _mm_set1_epi32(1))));
+
+        int lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), index);
+        out[0] = palette[lanes[0]];
+        out[1] = palette[lanes[1]];
+        out[2] = palette[lanes[2]];
+        out[3] = palette[lanes[3]];
+    }
+}
+
+uint32_t Gradient::ColorAt(double t) const
+{
+    if (stops.empty())
+        return 0;
+    if (t <= stops.front().position)
+        return Bgra(stops.front().r, stops.front().g, stops.front().b);
+    for (size_t i = 1; i < stops.size(); ++i)
+    {
+        const GradientStop& a = stops[i - 1];
+        const GradientStop& b = stops[i];
+        if (t > b.position)
+            continue;
+        const double u = (t - a.position) / (b.position - a.position);
+        return Bgra((int)lround(a.r + (b.r - a.r) * u),
+                    (int)lround(a.g + (b.g - a.g) * u),
+                    (int)lround(a.b + (b.b - a.b) * u));
+    }
+    return Bgra(stops.back().r, stops.back().g, stops.back().b);
+}
+
+bool Gradient::Load(const char* path, Gradient& out, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = std::string("Cannot open ") + path;
+        return false;
+    }
+
+    Gradient gradient;
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number)
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        double position;
+        int r, g, b;
+        std::string rest;
+        const double previous = gradient.stops.empty() ? 0.0 : gradient.stops.back().position;
+        if (!(fields >> position >> r >> g >> b) || (fields >> rest) ||
+            position < previous || position > 1.0 || (!gradient.stops.empty() && position == previous) ||
+            r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255)
+        {
+            error = std::string(path) + " line " + std::to_string(number) +
+                    ": expected \"position r g b\" with increasing positions in [0, 1] and channels in 0..255";
+            return false;
+        }
+        gradient.stops.push_back({ position, (uint8_t)r, (uint8_t)g, (uint8_t)b });
+    }
+
+    if (gradient.stops.empty())
+    {
+        error = std::string(path) + " has no color stops";
+        return false;
+    }
+    out = std::move(gradient);
+    return true;
+}
+
+void Palette::Update(int maxIter, int steps, const std::shared_ptr<const Gradient>& gradient,
+                     int rmin, int rmax, int gmin, int gmax, int bmin, int bmax)
+{
+    const int ramp[6] = { rmin, rmax, gmin, gmax, bmin, bmax };
+    if (!m_equalized && maxIter == m_maxIter && steps == m_steps && gradient == m_gradient &&
+        (gradient || std::equal(ramp, ramp + 6, m_ramp)))
+        return;
+
+    const int entries = maxIter * steps;
+    m_table.resize((size_t)entries + 1);
+    for (int k = 0; k < entries; ++k)
+    {
+        if (gradient)
+            m_table[(size_t)k] = gradient->ColorAt((double)k / entries);
+        else
+            m_table[(size_t)k] = Bgra((int)(rmin + (((long long)(rmax - rmin) * k) / entries)),
+                                      (int)(gmin + (((long long)(gmax - gmin) * k) / entries)),
+                                      (int)(bmin + (((long long)(bmax - bmin) * k) / entries)));
+    }
+    m_table[(size_t)entries] = 0; // inside - black
+
+    m_maxIter = maxIter;
+    m_steps = steps;
+    m_gradient = gradient;
+    std::copy(ramp, ramp + 6, m_ramp);
+    m_equalized = false;
+    ++m_version;
+}
+
+void Palette::Equalize(const std::vector<uint32_t>& histogram)
+{
+    uint64_t total = 0;
+    for (int n = 0; n < m_maxIter; ++n)
+        total += histogram[(size_t)n];
+    const double scale = total ? 1.0 / (double)total : 0.0;
+
+    // below: escaped pixels with a count under n, as a share of all escaped pixels.
+    uint64_t below = 0;
+    for (int n = 0; n < m_maxIter; ++n)
+    {
+        const double t0 = below * scale;
+        below += histogram[(size_t)n];
+        const double t1 = below * scale;
+        for (int j = 0; j < m_steps; ++j)
+            m_table[(size_t)n * m_steps + j] = ColorAt(t0 + (t1 - t0) * j / m_steps);
+    }
+
+    m_equalized = true;
+    ++m_version;
+}
+
+uint32_t Palette::ColorAt(double t) const
+{
+    if (m_gradient)
+        return m_gradient->ColorAt(t);
+    return Bgra((int)lround(m_ramp[0] + (m_ramp[1] - m_ramp[0]) * t),
+                (int)lround(m_ramp[2] + (m_ramp[3] - m_ramp[2]) * t),
+                (int)lround(m_ramp[4] + (m_ramp[5] - m_ramp[4]) * t));
+}
+
+double SmoothIteration(int iter, double norm)
+{
+    return iter + 2.0 - log2(log2(norm));
+}
+
+void ColorizeSmoothRow(const uint32_t* palette, int maxIter, const int* iters, const float* norms, int count,
+                       uint32_t* out)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        ColorizeSmooth4(palette, maxIter, iters + i, norms + i, out + i);
+
+    if (i < count)
+    {
+        int tailIters[4] = { maxIter, maxIter, maxIter, maxIter };
+        float tailNorms[4] = { 4.0f, 4.0f, 4.0f, 4.0f };
+        uint32_t tailOut[4];
+        std::copy(iters + i, iters + count, tailIters);
+        std::copy(norms + i, norms + count, tailNorms);
+        ColorizeSmooth4(palette, maxIter, tailIters, tailNorms, tailOut);
+        std::copy(tailOut, tailOut + (count - i), out + i);
+    }
+}
+
+double SmoothIterationMaxError()
+{
+    // Norms from just above 4 to FLT_MAX in steps of 2^(1/4096), four at a time.
+    double worst = 0.0;
+    const double ratio = exp2(1.0 / 4096);
+    for (double norm = 4.0 * ratio; norm < FLT_MAX; )
+    {
+        float lanes[4], fraction[4];
+        for (float& lane : lanes)
+        {
+            lane = (float)std::min(norm, (double)FLT_MAX);
+            norm *= ratio;
+        }
+        _mm_storeu_ps(fraction, SmoothFraction(_mm_loadu_ps(lanes)));
+        for (int k = 0; k < 4; ++k)
+            worst = std::max(worst, fabs(fraction[k] - SmoothIteration(0, lanes[k])));
+    }
+    return worst;
+}
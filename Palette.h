@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// One color of a gradient, at a position in [0, 1] along it.
+struct GradientStop
+{
+    double position;
+    uint8_t r, g, b;
+};
+
+// A color gradient, interpolated linearly in RGB between its stops. Escape counts map onto it
+// as iter / maxIter, like the default ramp.
+struct Gradient
+{
+    std::vector<GradientStop> stops; // increasing positions
+
+    // Color at t in [0, 1] as a BGRA pixel; t outside the stops takes the nearest end stop.
+    uint32_t ColorAt(double t) const;
+
+    // Reads a gradient file: one stop per line as "position r g b", positions increasing within
+    // [0, 1] and channels in 0..255. Blank lines and lines starting with '#' are skipped.
+    // Returns false with a message in error when the file cannot be read or a line is malformed.
+    static bool Load(const char* path, Gradient& out, std::string& error);
+};
+
+// Palette entries per iteration for smooth coloring: fractional escape counts are resolved
+// to 1/16 of an iteration.
+const int kSmoothSteps = 16;
+
+// BGRA lookup table the colorization pass indexes with escape counts, so coloring a pixel is
+// one load. With steps entries per iteration, entry k colors the count k / steps for k below
+// maxIter * steps, and the last entry (inside) is black. steps is 1 to color by escape count
+// and kSmoothSteps for smooth coloring. The table is rebuilt only when the iteration limit,
+// the resolution or the colors change.
+class Palette
+{
+public:
+    // Builds the table from the gradient, or from the linear ramp between the channel bounds
+    // when gradient is null. Does nothing when it was built from the same inputs.
+    void Update(int maxIter, int steps, const std::shared_ptr<const Gradient>& gradient,
+                int rmin, int rmax, int gmin, int gmax, int bmin, int bmax);
+
+    // Histogram equalization: rebuilds the table from the same colors so that each escape
+    // count n takes the color at the share of escaped pixels with a lower count, and entries
+    // between counts interpolate to the next. histogram[n] is the number of pixels that
+    // escaped after n iterations, n in [0, maxIter). The next Update rebuilds the table.
+    void Equalize(const std::vector<uint32_t>& histogram);
+
+    const uint32_t* Table() const { return m_table.data(); }
+    int Steps() const { return m_steps; }
+
+    // Changes with every rebuild, so frames can tell whether they were colored alike.
+    unsigned Version() const { return m_version; }
+
+private:
+    // Color at t in [0, 1] of the gradient or ramp the table was built from.
+    uint32_t ColorAt(double t) const;
+
+    std::vector<uint32_t> m_table;
+    unsigned m_version = 0;
+    bool m_equalized = false;
+    int m_maxIter = -1;
+    int m_steps = 0;
+    std::shared_ptr<const Gradient> m_gradient;
+    int m_ramp[6] = {};
+};
+
+// Smooth escape count of a pixel that escaped after iter iterations with |z|^2 = norm:
+// iter + 2 - log2(log2 norm). For the bailout |z|^2 > 4 it is continuous across iteration
+// bands and lies in (iter - 1/2, iter + 1] for pixels of the set's neighbourhood. Evaluated
+// with libm; ColorizeSmoothRow is checked against it.
+double SmoothIteration(int iter, double norm);
+
+// Colors count pixels from their escape counts and norms through a palette of kSmoothSteps
+// entries per iteration, four pixels at a time with SSE2 and a polynomial log2 in place of
+// libm. Counts outside [0, maxIter) take the inside color.
+void ColorizeSmoothRow(const uint32_t* palette, int maxIter, const int* iters, const float* norms, int count,
+                       uint32_t* out);
+
+// Largest difference, in iterations, between the smooth count ColorizeSmoothRow uses and
+// SmoothIteration over every norm an escape can leave (4 to FLT_MAX). It stays far below one
+// palette step (1 / kSmoothSteps), so no pixel is more than one entry off.
+double SmoothIterationMaxError();
@@ -0,0 +1,403 @@
+#include "Perturbation.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+
+void ComputeReferenceOrbit(const BigFixed& cx, const BigFixed& cy, int maxIter, ReferenceOrbit& orbit)
+{
+    orbit.zx.clear();
+    orbit.zy.clear();
+    orbit.zx.reserve((size_t)maxIter + 1);
+    orbit.zy.reserve((size_t)maxIter + 1);
+    orbit.cx = cx.ToDouble();
+    orbit.cy = cy.ToDouble();
+    orbit.maxIter = maxIter;
+    orbit.series = SeriesSkip();
+    orbit.bla = BlaTable();
+
+    const int limbs = cx.FractionLimbs() > cy.FractionLimbs() ? cx.FractionLimbs() : cy.FractionLimbs();
+    BigFixed x(0.0, limbs), y(0.0, limbs);
+    orbit.zx.push_back(0.0);
+    orbit.zy.push_back(0.0);
+
+    for (int n = 0; n < maxIter; ++n)
+    {
+        // Three squarings per step: 2xy = (x + y)^2 - x^2 - y^2.
+        const BigFixed x2 = x.Square();
+        const BigFixed y2 = y.Square();
+        if ((x2 + y2).ToDouble() > 4.0)
+            break; // Z_n escaped and is already stored
+
+        const BigFixed s2 = (x + y).Square();
+        y = s2 - x2 - y2 + cy;
+        x = x2 - y2 + cx;
+
+        orbit.zx.push_back(x.ToDouble());
+        orbit.zy.push_back(y.ToDouble());
+    }
+}
+
+void ApproximateSeries(ReferenceOrbit& orbit, double extentX, double extentY, double scale, int scaleExp)
+{
+    // Largest error allowed at a validation point, in pixels of the dz it approximates.
+    const double kSeriesTolerance = 1e-3;
+    const int kPoints = 8;
+
+    typedef std::complex<double> Complex;
+    SeriesSkip& series = orbit.series;
+    series = SeriesSkip();
+
+    const double radius = hypot(extentX, extentY); // squaring would underflow past about 1e-160
+    if (!(radius > 0))
+        return;
+
+    // Everything below is held as mantissa * 2^e with one shared exponent e (like the stored
+    // coefficients): the validation offsets dz[i] = 2^e w[i], and dc = 2^scaleExp d[i].
+    Complex d[kPoints], u[kPoints], w[kPoints];
+    int k = 0;
+    for (int sy = -1; sy <= 1; ++sy)
+        for (int sx = -1; sx <= 1; ++sx)
+            if (sx != 0 || sy != 0)
+            {
+                d[k] = Complex(sx * extentX, sy * extentY);
+                u[k] = d[k] / radius;
+                ++k;
+            }
+
+    int e = scaleExp;
+    double dcUnit = 1.0;                    // 2^(scaleExp - e)
+    const int last = static_cast<int>(orbit.zx.size()) - 1;
+    Complex a, b, c;
+    for (int n = 0; n + 1 < last; ++n)
+    {
+        // 2^e a' = 2 Z 2^e a + radius 2^scaleExp, 2^e b' = 2 Z 2^e b + (2^e a)^2, ...
+        const double eUnit = ldexp(1.0, e);  // 0 far below the double range, where those terms vanish
+        const Complex twoZ(2.0 * orbit.zx[n], 2.0 * orbit.zy[n]);
+        Complex na = twoZ * a + radius * dcUnit;
+        Complex nb = twoZ * b + eUnit * a * a;
+        Complex nc = twoZ * c + eUnit * 2.0 * a * b;
+        Complex nw[kPoints];
+        for (int i = 0; i < kPoints; ++i)
+            nw[i] = (twoZ + eUnit * w[i]) * w[i] + d[i] * dcUnit;
+
+        // Renormalize when a leaves [2^-32, 2^32] so nothing over- or underflows.
+        int ne = e;
+        double shift = 1.0;
+        const double mag = fmax(fabs(na.real()), fabs(na.imag()));
+        if (mag > 4294967296.0 || (mag > 0 && mag < 1.0 / 4294967296.0))
+        {
+            int t = 0;
+            frexp(mag, &t);
+            ne = e + t;
+            shift = ldexp(1.0, -t);
+            na *= shift; nb *= shift; nc *= shift;
+            for (int i = 0; i < kPoints; ++i) nw[i] *= shift;
+        }
+
+        // Allowed error of 2^e w in units of 2^e: tolerance * |A| * pixel spacing.
+        const double allowed = kSeriesTolerance * abs(na) / radius * scale;
+        const Complex nextZ(orbit.zx[n + 1], orbit.zy[n + 1]);
+        const double neUnit = ldexp(1.0, ne);
+        bool valid = true;
+        for (int i = 0; i < kPoints; ++i)
+        {
+            const Complex approx = (na + (nb + nc * u[i]) * u[i]) * u[i];
+            if (norm(nextZ + neUnit * nw[i]) > 4.0 || abs(approx - nw[i]) > allowed)
+                valid = false;
+        }
+        if (!valid)
+            break;
+
+        a = na; b = nb; c = nc;
+        for (int i = 0; i < kPoints; ++i) w[i] = nw[i];
+        e = ne;
+        dcUnit = ldexp(1.0, scaleExp - e);
+        series.iterations = n + 1;
+        series.radius = radius;
+        series.exponent = e;
+        series.a = a; series.b = b; series.c = c;
+    }
+}
+
+namespace
+{
+    // Relative size of the dropped dz^2 term a single linear step may have: |dz| < eps |Z|.
+    // 2^-28 keeps the counts that change closer to exact than a 1/1000-pixel shift of the view;
+    // 2^-24 is about 1.3x faster on mixed views but changes more of them.
+    const double kBlaEpsilon = 1.0 / 268435456.0; // 2^-28
+    // Maps with larger coefficients are not stored, so a step can never overflow (the scaled
+    // kernel applies them to mantissas up to 2^64).
+    const double kBlaMaxCoefficient = 1e270;
+    // Entries merged by one task.
+    const int kBlaChunk = 4096;
+    // Pauldelbrot's glitch test |z|^2 < tolerance |Z|^2, i.e. |z| < 10^-3 |Z|.
+    const double kGlitchTolerance = 1e-6;
+
+    // x followed by y: A = A_y A_x, B = A_y B_x + B_y, valid while dz stays inside R_x and the
+    // intermediate offset A_x dz + B_x dc inside R_y.
+    BlaStep MergeBla(const BlaStep& x, const BlaStep& y, double dcMax)
+    {
+        BlaStep r;
+        r.a = y.a * x.a;
+        r.b = y.a * x.b + y.b;
+        const double ax = abs(x.a);
+        const double ry = ax > 0 ? (y.radius - abs(x.b) * dcMax) / ax : 0.0;
+        r.radius = fmax(0.0, fmin(x.radius, ry));
+        if (!(fmax(abs(r.a), abs(r.b)) < kBlaMaxCoefficient))
+            r.radius = 0.0;
+        return r;
+    }
+
+    // Longest table run of at most maxLength iterations starting at reference iteration m that
+    // admits |dz|^2 = dz2; nullptr if there is none. Radii shrink with the run length, so the
+    // search stops at the first level that fails.
+    inline const BlaStep* FindBla(const BlaTable& t, int m, double dz2, int maxLength, int& length)
+    {
+        const int j = m - 1;
+        const BlaStep* best = nullptr;
+        for (size_t k = 0; k < t.levels.size(); ++k)
+        {
+            const int len = 2 << k;
+            if (j < 0 || (j & (len - 1)) != 0 || len > maxLength)
+                break;
+            const size_t index = static_cast<size_t>(j >> (k + 1));
+            if (index >= t.levels[k].size())
+                break;
+            const BlaStep& s = t.levels[k][index];
+            if (!(dz2 < s.radius * s.radius))
+                break;
+            best = &s;
+            length = len;
+        }
+        return best;
+    }
+
+    // Runs one pixel from iteration n, at reference iteration m, with plain double offsets and
+    // returns its count (or MarkGlitched). norm receives |z|^2 of the last iterate.
+    inline int ContinuePixel(const ReferenceOrbit& ref, int n, int m, int maxIter, double dzx, double dzy,
+                             double dcx, double dcy, bool rebase, float& norm)
+    {
+        const double* refX = ref.zx.data();
+        const double* refY = ref.zy.data();
+        const int last = static_cast<int>(ref.zx.size()) - 1;
+
+        while (n < maxIter)
+        {
+            const double zx = refX[m] + dzx;
+            const double zy = refY[m] + dzy;
+            const double z2 = zx * zx + zy * zy;
+            norm = static_cast<float>(z2);
+            if (z2 > 4.0)
+                break;
+
+            const double dz2 = dzx * dzx + dzy * dzy;
+            if (m == last || (rebase && z2 < dz2))
+            {
+                // Continue from Z_0 = 0 with dz = z; this also carries pixels past the end of
+                // a reference that escaped before them.
+                dzx = zx;
+                dzy = zy;
+                m = 0;
+                continue;
+            }
+            if (z2 < kGlitchTolerance * (refX[m] * refX[m] + refY[m] * refY[m]))
+                return MarkGlitched(n);
+
+            int length = 0;
+            const int maxLength = std::min(last - m, maxIter - n);
+            if (const BlaStep* s = FindBla(ref.bla, m, dz2, maxLength, length))
+            {
+                const double nx = s->a.real() * dzx - s->a.imag() * dzy + s->b.real() * dcx - s->b.imag() * dcy;
+                dzy = s->a.real() * dzy + s->a.imag() * dzx + s->b.real() * dcy + s->b.imag() * dcx;
+                dzx = nx;
+                n += length;
+                m += length;
+                continue;
+            }
+
+            // dz' = (2 Z + dz) dz + dc
+            const double tx = 2.0 * refX[m] + dzx;
+            const double ty = 2.0 * refY[m] + dzy;
+            const double nx = tx * dzx - ty * dzy + dcx;
+            dzy = tx * dzy + ty * dzx + dcy;
+            dzx = nx;
+            ++n;
+            ++m;
+        }
+        return n;
+    }
+
+    // Pixels whose spacing is below the double range. dz = 2^e (wx + i wy) with one exponent
+    // for both parts, renormalized only when the mantissas drift out of [2^-64, 2^64]; dc is
+    // kept pre-scaled to 2^e so each step is plain double arithmetic. dz^2 is dropped while dz
+    // itself is below the double range, where it is negligible next to 2 Z dz. Neither the
+    // rebase nor the glitch test can trigger while dz is that small next to Z.
+    int IterateRowScaled(const RowParams& p, int x0, int count, int* iters, float* norms)
+    {
+        // Once dz reaches 2^kPlainDeltaExponent (times a mantissa >= 2^-64) it is a normal
+        // double and the pixel continues in ContinuePixel.
+        const int kPlainDeltaExponent = -900;
+        const double kHigh = 18446744073709551616.0; // 2^64
+        const double kLow = 1.0 / kHigh;
+
+        const ReferenceOrbit& ref = *p.reference;
+        const double* refX = ref.zx.data();
+        const double* refY = ref.zy.data();
+        const int last = static_cast<int>(ref.zx.size()) - 1;
+        const int maxIter = p.maxIter;
+        const int limit = maxIter < last ? maxIter : last;
+        const SeriesSkip& series = ref.series;
+        const double dcy = p.imag;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const double dcx = p.cx + ((x0 + i * p.stride) - p.halfW) * p.scale;
+
+            double wx = 0.0, wy = 0.0;
+            int e = p.scaleExp;
+            int n = 0;
+            if (series.iterations > 0 && series.iterations < maxIter)
+            {
+                const std::complex<double> u(dcx / series.radius, dcy / series.radius);
+                const std::complex<double> dz = (series.a + (series.b + series.c * u) * u) * u;
+                wx = dz.real();
+                wy = dz.imag();
+                e = series.exponent;
+                n = series.iterations;
+            }
+
+            double unit = ldexp(1.0, e);
+            double dcxs = ldexp(dcx, p.scaleExp - e);
+            double dcys = ldexp(dcy, p.scaleExp - e);
+            norms[i] = 0.0f;
+            while (n < limit && e < kPlainDeltaExponent)
+            {
+                const double dzx = wx * unit;
+                const double dzy = wy * unit;
+                const double zx = refX[n] + dzx;
+                const double zy = refY[n] + dzy;
+                norms[i] = static_cast<float>(zx * zx + zy * zy);
+                if (zx * zx + zy * zy > 4.0)
+                    break;
+
+                int length = 0;
+                if (const BlaStep* s = FindBla(ref.bla, n, dzx * dzx + dzy * dzy, limit - n, length))
+                {
+                    const double nx = s->a.real() * wx - s->a.imag() * wy + s->b.real() * dcxs - s->b.imag() * dcys;
+                    wy = s->a.real() * wy + s->a.imag() * wx + s->b.real() * dcys + s->b.imag() * dcxs;
+                    wx = nx;
+                    n += length;
+                }
+                else
+                {
+                    const double tx = 2.0 * refX[n] + dzx;
+                    const double ty = 2.0 * refY[n] + dzy;
+                    const double nx = tx * wx - ty * wy + dcxs;
+                    wy = tx * wy + ty * wx + dcys;
+                    wx = nx;
+                    ++n;
+                }
+
+                const double mag = fmax(fabs(wx), fabs(wy));
+                if (mag > kHigh || (mag < kLow && mag > 0))
+                {
+                    int t = 0;
+                    frexp(mag, &t);
+                    wx = ldexp(wx, -t);
+                    wy = ldexp(wy, -t);
+                    e += t;
+                    unit = ldexp(1.0, e);
+                    dcxs = ldexp(dcx, p.scaleExp - e);
+                    dcys = ldexp(dcy, p.scaleExp - e);
+                }
+            }
+
+            // The loop stops early only when the pixel escapes; otherwise dz reached the double
+            // range or the reference ended, and ContinuePixel takes over.
+            const bool escaped = n < limit && e < kPlainDeltaExponent;
+            if (!escaped && n < maxIter)
+                n = ContinuePixel(ref, n, n, maxIter, wx * unit, wy * unit, ldexp(dcx, p.scaleExp),
+                                  ldexp(dcy, p.scaleExp), p.rebase, norms[i]);
+
+            iters[i] = n;
+        }
+        return 0;
+    }
+}
+
+void BuildBlaTable(ReferenceOrbit& orbit, double dcMax, ThreadPool& pool)
+{
+    BlaTable& t = orbit.bla;
+    t.levels.clear();
+    t.dcMax = dcMax;
+
+    // Single steps m = 1 .. last - 1 (Z_m to Z_{m+1}), merged in pairs into level 0.
+    const int steps = static_cast<int>(orbit.zx.size()) - 2;
+    auto single = [&](int m)
+    {
+        BlaStep s;
+        s.a = std::complex<double>(2.0 * orbit.zx[m], 2.0 * orbit.zy[m]);
+        s.b = 1.0;
+        s.radius = kBlaEpsilon * hypot(orbit.zx[m], orbit.zy[m]);
+        return s;
+    };
+
+    for (int count = steps / 2; count > 0; count /= 2)
+    {
+        const size_t k = t.levels.size();
+        t.levels.emplace_back(static_cast<size_t>(count));
+        std::vector<BlaStep>& level = t.levels.back();
+        const std::vector<BlaStep>* below = k > 0 ? &t.levels[k - 1] : nullptr;
+
+        pool.ParallelFor((count + kBlaChunk - 1) / kBlaChunk, [&](int chunk, int)
+        {
+            const int end = std::min(count, (chunk + 1) * kBlaChunk);
+            for (int j = chunk * kBlaChunk; j < end; ++j)
+            {
+                level[j] = below ? MergeBla((*below)[2 * j], (*below)[2 * j + 1], dcMax)
+                                 : MergeBla(single(1 + 2 * j), single(2 + 2 * j), dcMax);
+            }
+        });
+
+        // Runs that admit no dz at all would only be rejected at lookup; stop here instead.
+        bool any = false;
+        for (const BlaStep& s : level)
+            if (s.radius > 0) { any = true; break; }
+        if (!any)
+        {
+            t.levels.pop_back();
+            break;
+        }
+    }
+}
+
+int IterateRowPerturbation(const RowParams& p, int x0, int count, int* iters, float* norms)
+{
+    if (p.scaleExp != 0)
+        return IterateRowScaled(p, x0, count, iters, norms);
+
+    const ReferenceOrbit& ref = *p.reference;
+    const int maxIter = p.maxIter;
+    const double dcy = p.imag;
+    const SeriesSkip& series = ref.series;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const double dcx = p.cx + ((x0 + i * p.stride) - p.halfW) * p.scale;
+
+        double dzx = 0.0, dzy = 0.0;
+        int n = 0;
+        if (series.iterations > 0 && series.iterations < maxIter)
+        {
+            const std::complex<double> u(dcx / series.radius, dcy / series.radius);
+            const std::complex<double> dz = ldexp(1.0, series.exponent) * ((series.a + (series.b + series.c * u) * u) * u);
+            dzx = dz.real();
+            dzy = dz.imag();
+            n = series.iterations;
+        }
+        norms[i] = 0.0f;
+        iters[i] = ContinuePixel(ref, n, n, maxIter, dzx, dzy, dcx, dcy, p.rebase, norms[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "BigFixed.h"
+#include "MandelbrotKernels.h"
+
+#include <complex>
+#include <vector>
+
+// Deep-zoom engine. Past about 1e-13 per pixel neighbouring pixels round to the same double
+// and the direct kernels show blocks. Instead, one reference orbit Z_n is iterated at the
+// view center in BigFixed and stored in doubles, and every pixel c = C + dc iterates only its
+// offset from it:
+//
+//     dz_{n+1} = 2 Z_n dz_n + dz_n^2 + dc,    z_n = Z_n + dz_n
+//
+// The offsets are tiny, so doubles hold them to full relative precision at any depth a
+// double exponent can reach. Below that (pixel spacing under 2^kMinPlainScaleExponent) the
+// spacing is carried as mantissa * 2^scaleExp and the offsets get a separate exponent until
+// they grow back into the double range.
+//
+// While dz stays small it is a smooth function of dc, so the first iterations of every pixel
+// can be replaced by a cubic in dc (series approximation):
+//
+//     dz_n ~ A_n dc + B_n dc^2 + C_n dc^3
+//     A_{n+1} = 2 Z_n A_n + 1,   B_{n+1} = 2 Z_n B_n + A_n^2,   C_{n+1} = 2 Z_n C_n + 2 A_n B_n
+//
+// Further on, wherever dz is small next to Z the step is nearly linear, and runs of steps
+// collapse into one bilinear map (BLA):
+//
+//     dz_{m+l} ~ A dz_m + B dc    while |dz_m| < R
+//
+// Single steps have A = 2 Z_m, B = 1. A table of maps for runs of 2, 4, 8, ... iterations is
+// built once per reference orbit and view size, and each pixel takes the longest run whose
+// radius admits its current dz.
+//
+// A pixel whose z passes much closer to 0 than Z does loses the relative precision of dz and
+// comes out wrong (a glitch). Rebasing avoids most of them: as soon as |z| < |dz| the pixel
+// continues from the start of the reference with dz = z (Z_0 = 0), and the same happens when
+// it reaches the end of the reference. Pixels still caught by Pauldelbrot's test
+// |z| < 10^-3 |Z| are marked glitched and re-rendered against another reference (see
+// CorrectGlitches in Renderer.h).
+
+class ThreadPool;
+
+// Smallest binary exponent of a pixel spacing iterated with plain double offsets. Offsets of
+// up to a few thousand pixels then stay normal doubles (above 2^-1022) with room to spare.
+const int kMinPlainScaleExponent = -960;
+
+// Glitched pixels are stored as -2 - n, n being the iteration the glitch was detected at;
+// -1 stays free for Mariani-Silver's not-yet-computed pixels.
+inline int MarkGlitched(int n) { return -2 - n; }
+inline bool IsGlitched(int iters) { return iters <= -2; }
+inline int GlitchedCount(int iters) { return -2 - iters; }
+
+// Series coefficients at the iteration every pixel of the current view starts from. They are
+// stored for u = dc / radius with a shared exponent, 2^exponent a = A radius,
+// 2^exponent b = B radius^2 and 2^exponent c = C radius^3, which keeps them in double range
+// however deep the view is. radius is in the same units as the row offsets (2^scaleExp).
+struct SeriesSkip
+{
+    int iterations = 0;                 // 0: no skip, start every pixel at dz_0 = 0
+    double radius = 1.0;
+    int exponent = 0;
+    std::complex<double> a, b, c;
+};
+
+// One bilinear map: dz_{m+length} = a dz_m + b dc for |dz_m| < radius.
+struct BlaStep
+{
+    std::complex<double> a, b;
+    double radius = 0.0;
+};
+
+// levels[k][j] covers the 2^(k+1) iterations starting at m = 1 + j 2^(k+1) (Z_0 = 0 has no
+// useful single step). Built for pixel offsets up to |dc| = dcMax.
+struct BlaTable
+{
+    std::vector<std::vector<BlaStep>> levels;
+    double dcMax = -1.0;                // -1: not built
+};
+
+struct ReferenceOrbit
+{
+    std::vector<double> zx, zy; // Z_0 = 0 .. Z_last; when the reference escapes Z_last is the escaped value
+    double cx = 0, cy = 0;      // reference point rounded to double
+    int maxIter = 0;
+    SeriesSkip series;          // for the current view, see ApproximateSeries
+    BlaTable bla;               // see BuildBlaTable
+};
+
+// Iterates the reference point (cx, cy) at the precision of its arguments, up to maxIter
+// iterations or until it escapes.
+void ComputeReferenceOrbit(const BigFixed& cx, const BigFixed& cy, int maxIter, ReferenceOrbit& orbit);
+
+// Chooses how many iterations the series may skip for a view extending extentX / extentY
+// (times 2^scaleExp) world units from the reference on each side, and stores the coefficients
+// in orbit.series.
+// The series is checked against exact perturbation at the corners and edge midpoints: it
+// stops at the first iteration where it is off by more than a fraction of a pixel at any of
+// them, or one of them escapes.
+void ApproximateSeries(ReferenceOrbit& orbit, double extentX, double extentY, double scale, int scaleExp = 0);
+
+// Builds orbit.bla for pixel offsets up to dcMax world units from the reference. Each level is
+// merged from the one below in parallel on pool.
+void BuildBlaTable(ReferenceOrbit& orbit, double dcMax, ThreadPool& pool);
+
+// RowKernel for perturbation: p.reference must be set, and p.cx / p.imag are the offsets of
+// the row from the reference point (so the pixel offset is p.cx + (x - halfW) * scale).
+// Pixels start at the iteration given by p.reference->series and then jump ahead through
+// p.reference->bla wherever it applies. With p.scaleExp != 0 the offsets are iterated as
+// mantissa and exponent until they reach the double range. Pixels rebase onto the start of
+// the reference when they reach its end and, if p.rebase is set, whenever |z| < |dz|; those
+// that glitch anyway are stored as MarkGlitched(n).
+int IterateRowPerturbation(const RowParams& p, int x0, int count, int* iters, float* norms);
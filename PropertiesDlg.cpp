@@ -2,6 +2,7 @@
 #include "resource.h"
 #include <string>
 #include <cstdlib> // for atof
+#include <math.h>
 #include <commctrl.h> // for NMUPDOWN
 
 AppState g_state;
@@ -10,26 +11,48 @@ AppState g_state;
 // Initialize with values consistent with g_state defaults so the dialog has sane defaults.
 Properties g_props = {
     g_state.maxIter,                 // maxIter (50)
-    g_state.centerX,                 // centerReal (-0.75)
-    g_state.centerY,                 // centerImag (0.0)
-    g_state.height * g_state.scale,  // height in world units (1200 * 3/800 = 4.5)
+    g_state.centerRe,                // centerReal (-0.75)
+    g_state.centerIm,                // centerImag (0.0)
+    FloatExp(g_state.height * g_state.scale), // height in world units (1200 * 3/800 = 4.5)
     100, 255,                        // rmin, rmax
     0, 255,                          // gmin, gmax
     0, 0                             // bmin, bmax
 };
 
-static void SetDlgDouble(HWND hDlg, int controlId, double value)
+static void SetDlgFloatExp(HWND hDlg, int controlId, const FloatExp& value)
 {
-    char buf[64];
-    sprintf_s(buf, "%.17g", value);
-    SetDlgItemTextA(hDlg, controlId, buf);
+    SetDlgItemTextA(hDlg, controlId, value.ToString(17).c_str());
 }
 
-static double GetDlgDouble(HWND hDlg, int controlId)
+// Leaves value unchanged when the text is not a number or is still the one SetDlgFloatExp
+// showed for it, so an untouched field keeps its exact value.
+static void GetDlgFloatExp(HWND hDlg, int controlId, FloatExp& value)
 {
     char buf[64];
     GetDlgItemTextA(hDlg, controlId, buf, (int)sizeof(buf));
-    return std::stod(buf);
+    if (value.ToString(17) != buf)
+        FloatExp::Parse(buf, value);
+}
+
+// Enough decimals to place the center to a fraction of a pixel at the given spacing.
+static int CenterDigits(const FloatExp& scale)
+{
+    return max(17, static_cast<int>(ceil(-scale.Log2Abs() * log10(2.0))) + 3);
+}
+
+static void SetDlgBigFixed(HWND hDlg, int controlId, const BigFixed& value, int digits)
+{
+    SetDlgItemTextA(hDlg, controlId, value.ToString(digits).c_str());
+}
+
+// Leaves value unchanged when the text is not a number or is still the one SetDlgBigFixed
+// showed for it with the given digits.
+static void GetDlgBigFixed(HWND hDlg, int controlId, int fractionLimbs, int shownDigits, BigFixed& value)
+{
+    std::string buf((size_t)GetWindowTextLengthA(GetDlgItem(hDlg, controlId)) + 1, '\0');
+    GetDlgItemTextA(hDlg, controlId, &buf[0], (int)buf.size());
+    if (value.ToString(shownDigits) != buf.c_str())
+        BigFixed::Parse(buf.c_str(), fractionLimbs, value);
 }
 
 static int GetDlgInt(HWND hDlg, int controlId)
@@ -61,9 +84,12 @@ INT_PTR CALLBACK PropertiesDlgProc(HWND hDlg, UINT message, WPARAM wParam, LPARA
     case WM_INITDIALOG:
         // Initialize controls from g_state (existing behavior)
         SetDlgItemInt(hDlg, IDC_MAX_ITER, g_state.maxIter, FALSE);
-        SetDlgDouble(hDlg, IDC_CENTER_REAL, g_state.centerX);
-        SetDlgDouble(hDlg, IDC_CENTER_IMAG, g_state.centerY);
-        SetDlgDouble(hDlg, IDC_HEIGHT, g_state.height * g_state.scale);
+        {
+            const FloatExp scale(g_state.scale, g_state.scaleExp);
+            SetDlgBigFixed(hDlg, IDC_CENTER_REAL, g_state.centerRe, CenterDigits(scale));
+            SetDlgBigFixed(hDlg, IDC_CENTER_IMAG, g_state.centerIm, CenterDigits(scale));
+            SetDlgFloatExp(hDlg, IDC_HEIGHT, scale * g_state.height);
+        }
         SetDlgItemInt(hDlg, IDC_RED_MIN, g_state.rmin, FALSE);
         SetDlgItemInt(hDlg, IDC_RED_MAX, g_state.rmax, FALSE);
         SetDlgItemInt(hDlg, IDC_GREEN_MIN, g_state.gmin, FALSE);
@@ -147,9 +173,15 @@ INT_PTR CALLBACK PropertiesDlgProc(HWND hDlg, UINT message, WPARAM wParam, LPARA
         {
             // Read current control values into g_props
             g_props.maxIter = GetDlgInt(hDlg, IDC_MAX_ITER);
-            g_props.centerReal = GetDlgDouble(hDlg, IDC_CENTER_REAL);
-            g_props.centerImag = GetDlgDouble(hDlg, IDC_CENTER_IMAG);
-            g_props.height = GetDlgDouble(hDlg, IDC_HEIGHT);
+            GetDlgFloatExp(hDlg, IDC_HEIGHT, g_props.height);
+            {
+                // parse the center at the precision the new height needs
+                const FloatExp scale = g_props.height / (g_state.height > 0 ? g_state.height : 1);
+                const int limbs = BigFixed::LimbsForScale(scale.m, scale.e);
+                const int shownDigits = CenterDigits(FloatExp(g_state.scale, g_state.scaleExp));
+                GetDlgBigFixed(hDlg, IDC_CENTER_REAL, limbs, shownDigits, g_props.centerReal);
+                GetDlgBigFixed(hDlg, IDC_CENTER_IMAG, limbs, shownDigits, g_props.centerImag);
+            }
             g_props.rmin = GetDlgInt(hDlg, IDC_RED_MIN);
             g_props.rmax = GetDlgInt(hDlg, IDC_RED_MAX);
             g_props.gmin = GetDlgInt(hDlg, IDC_GREEN_MIN);
@@ -1,5 +1,63 @@
 #pragma once
 #include <windows.h>
+#include <vector>
+#include "BigFixed.h"
+#include "FloatExp.h"
+#include "Palette.h"
+#include "Perturbation.h"
+#include "Renderer.h"
+
+// A 32-bit top-down DIB section a frame is rendered into. The render thread fills one while
+// the UI thread shows another; finished frames are swapped, never copied.
+struct FrameBuffer
+{
+    HBITMAP bitmap = nullptr;
+    uint32_t* pixels = nullptr; // pointer returned by CreateDIBSection
+    int width = 0;
+    int height = 0;
+    size_t pitchPixels = 0;     // row stride in pixels
+
+    // View the pixels show, so a frame can be drawn into a newer view as a preview.
+    BigFixed centerRe, centerIm;
+    double scale = 0.0;
+    int scaleExp = 0;
+};
+
+// Statistics of one rendered frame, filled by the render thread.
+struct FrameStats
+{
+    unsigned frame = 0;           // number of the request it was rendered for (AppState::requestedFrame)
+    KernelPrecision lanePrecision = KernelPrecision::Double; // lane type used
+    bool distance = false;        // iterated with distance estimation (not in perturbation frames)
+    double renderMs = 0.0;        // wall time
+    int maxIter = 0;              // max iterations it was rendered with
+    double probeMs = 0.0;         // automatic iterations: time spent on the probe grid
+    long long probePixels = 0;    // and probes iterated (every cap it tried)
+    double iterationMs = 0.0;     // of which filling the iteration buffer
+    double histogramMs = 0.0;     // histogram coloring: counting the escape counts, before coloring
+    double colorMs = 0.0;         // and coloring it
+    long long coloredPixels = 0;  // pixels the colorization pass wrote
+    int aaSamples = 0;            // antialiasing: samples per axis; 0: off
+    long long supersampledPixels = 0; // edge pixels it supersampled
+    double aaMs = 0.0;            // time spent finding and supersampling them
+    long long skippedPixels = 0;  // pixels found in the cardioid/bulb without iterating
+    long long computedPixels = 0; // pixels run through a kernel (Mariani-Silver fills the rest)
+    long long guessedPixels = 0;  // progressive: pixels taken from equal block corners
+    long long reusedPixels = 0;   // pan: pixels moved over from the previous frame
+    int cacheTiles = 0;           // tile cache: tiles covering the frame; 0: not on the tile grid
+    int cacheHits = 0;            // of which were cached
+    size_t cacheBytes = 0;        // and what the cache held after the frame
+    double firstPassMs = 0.0;     // progressive: time until the first (coarsest) pass was on screen
+
+    // deep zoom: set when the frame was past double precision and used perturbation
+    bool perturbation = false;
+    int referenceIterations = 0;  // length of the reference orbit
+    double referenceMs = 0.0;     // time spent computing it (0 when it was reused)
+    int seriesIterations = 0;     // iterations skipped by the series approximation
+    int blaLevels = 0;            // levels of its BLA table
+    double blaMs = 0.0;           // time spent building the table (0 when it was reused)
+    GlitchStats glitches;
+};
 
 struct AppState
 {
@@ -7,28 +65,46 @@ struct AppState
     //    int height = 600;
     int width = 1600;
     int height = 1200;
-    HBITMAP hBitmap = nullptr;
-    void* pixels = nullptr; // pointer returned by CreateDIBSection
+    FrameBuffer frame;            // last finished frame, shown by WM_PAINT (may lag a resize)
 
     // Color ramp bounds
     int rmin, rmax;
     int gmin, gmax;
     int bmin, bmax;
-
-    BITMAPINFO bmi;
+    std::shared_ptr<const Gradient> gradient; // loaded palette file; null: the ramp above
+    bool smoothColoring = false;  // color by the fractional escape count (View > Smooth Coloring)
+    bool histogramColoring = false; // equalize the palette over the frame's pixels (View > Histogram Coloring)
+    bool autoIter = false;        // choose maxIter per frame from a probe grid (View > Automatic Iterations)
+    bool antialias = false;       // supersample edge pixels (View > Antialiasing)
+    int aaSamples = 4;            // with aaSamples x aaSamples jittered samples (--aa=<n>)
+    bool distanceEstimation = false; // iterate with dz/dc for exterior distances (View > Distance Estimation)
+    bool tileCache = false;       // keep iterated tiles and snap the view to their grid (View > Tile Cache)
+    int tileCacheMB = 256;        // memory budget of the cached tiles (--tile-cache=<MB>)
 
     // world/view
     double centerX = -0.75;
     double centerY = 0.0;
+    // The exact center; centerX/centerY are its nearest doubles. Changed only through
+    // SetCenter/OffsetCenter, which grow its precision with the zoom.
+    BigFixed centerRe{ -0.75 };
+    BigFixed centerIm{ 0.0 };
+    // Whole-pixel pans keep the pixel grid: pixels are placed relative to the pan anchor, and
+    // the center sits (panX, panY) pixels from it (y down), so consecutive frames share their
+    // pixel coordinates exactly. SetCenter moves the anchor to the new center; see PanView.
+    BigFixed panAnchorRe{ -0.75 };
+    BigFixed panAnchorIm{ 0.0 };
+    int panX = 0, panY = 0;
     double scale = 3.0 / 800.0; // complex units per pixel (initial)
+    int scaleExp = 0;           // below 2^kMinPlainScaleExponent the spacing is scale * 2^scaleExp; see SetScale
     //    int maxIter = 900;
     int maxIter = 50;
 
     // render state
     bool dragging = false;
     POINT dragStart;
-    double dragCenterX, dragCenterY;
-    bool needRender = true;
+    int dragPanX = 0, dragPanY = 0; // panX/panY when the drag started
+    bool needRender = true;       // view changed; WM_PAINT hands it to the render thread
+    unsigned requestedFrame = 0;  // number of the last frame handed to the render thread
 
     // Selection/right-drag support:
     bool selecting = false;   // currently dragging right-button
@@ -36,8 +112,15 @@ struct AppState
     RECT selRect = { 0,0,0,0 };  // normalized selection rect (client coords)
     bool hasSelection = false; // whether a selection exists to act on
 
-    // row stride (bytes per scanline). 0 if no bitmap.
-    int pitch = 0;
+    // escape-time kernel chosen at startup (widest supported, or forced with --kernel=)
+    KernelIsa kernelIsa = KernelIsa::Scalar;
+    // float/double/double-double lanes: automatic by zoom depth unless forced with --precision=
+    KernelPrecision precision = KernelPrecision::Auto;
+    FrameStats stats;             // of the frame on screen
+
+    RenderMode renderMode = RenderMode::BruteForce;
+
+    bool rebase = true;           // deep zoom: rebase pixels onto the reference start (off with --no-rebase)
 
     // Ownership: whether this AppState was heap-allocated (for new windows)
     bool owned = false;
@@ -48,12 +131,12 @@ struct Properties
 {
     int maxIter;
 
-    // center (real + imag)
-    double centerReal;
-    double centerImag;
+    // center (real + imag), at full precision
+    BigFixed centerReal;
+    BigFixed centerImag;
 
     // height in world units (dialog shows Height), used to compute scale = height / window_height
-    double height;
+    FloatExp height;
 
     // color ramp bounds
     int rmin, rmax;
@@ -0,0 +1,679 @@
+// Tile renderer: fills the iteration buffer one tile at a time (brute force or
+// Mariani-Silver subdivision) and colors the tile into the DIB.
+
+#include "Renderer.h"
+#include "BigFixed.h"
+#include "Palette.h"
+#include "Perturbation.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    // Rectangles at most this many pixels across are iterated instead of split further;
+    // tracing their border would cost about as much as computing them.
+    const int kMinSubdivide = 6;
+
+    RowParams RowFor(const FrameParams& f, int y)
+    {
+        // imag = centerY - (y - halfH) * scale; the double-double kernels also get the rounding
+        // error of that sum (two-sum) plus the low part of the center.
+        const double offset = -(y - f.halfH) * f.scale;
+        RowParams p{ f.centerX, f.halfW, f.scale, f.centerY + offset, f.maxIter, f.reference };
+        const double bb = p.imag - f.centerY;
+        p.imagLo = (f.centerY - (p.imag - bb)) + (offset - bb) + f.centerYLo;
+        p.cxLo = f.centerXLo;
+        p.scaleExp = f.scaleExp;
+        p.rebase = f.rebase;
+        return p;
+    }
+
+    int* IterRow(const FrameParams& f, int y)
+    {
+        return f.iterations + (size_t)y * f.width;
+    }
+
+    float* NormRow(const FrameParams& f, int y)
+    {
+        return f.norms + (size_t)y * f.width;
+    }
+
+    void IterateTileBruteForce(const FrameParams& f, int x0, int y0, int tw, int th, TileStats& stats)
+    {
+        for (int y = y0; y < y0 + th; ++y)
+        {
+            RowParams params = RowFor(f, y);
+            stats.skipped += f.iterateRow(params, x0, tw, IterRow(f, y) + x0, NormRow(f, y) + x0);
+        }
+        stats.computed += (long long)tw * th;
+    }
+
+    // Mariani-Silver works on inclusive pixel rectangles that share their edges with their
+    // neighbours. Pixels not yet computed hold -1, so a shared edge is only iterated once.
+    struct Subdivider
+    {
+        const FrameParams& f;
+        TileStats& stats;
+
+        // Iterates the not-yet-computed pixels of row y in [xa, xb].
+        void Span(int y, int xa, int xb)
+        {
+            int* row = IterRow(f, y);
+            RowParams params = RowFor(f, y);
+            for (int x = xa; x <= xb; )
+            {
+                if (row[x] != -1) { ++x; continue; }
+                int end = x;
+                while (end <= xb && row[end] == -1) ++end;
+                stats.skipped += f.iterateRow(params, x, end - x, row + x, NormRow(f, y) + x);
+                stats.computed += end - x;
+                x = end;
+            }
+        }
+
+        // Iterates the not-yet-computed pixels of column x in [ya, yb], one at a time.
+        void Column(int x, int ya, int yb)
+        {
+            for (int y = ya; y <= yb; ++y)
+            {
+                int* p = IterRow(f, y) + x;
+                if (*p != -1) continue;
+                RowParams params = RowFor(f, y);
+                stats.skipped += f.iteratePixel(params, x, 1, p, NormRow(f, y) + x);
+                ++stats.computed;
+            }
+        }
+
+        bool BorderIsUniform(int x0, int y0, int x1, int y1, int value)
+        {
+            const int* top = IterRow(f, y0);
+            const int* bottom = IterRow(f, y1);
+            for (int x = x0; x <= x1; ++x)
+                if (top[x] != value || bottom[x] != value) return false;
+            for (int y = y0 + 1; y < y1; ++y)
+                if (IterRow(f, y)[x0] != value || IterRow(f, y)[x1] != value) return false;
+            return true;
+        }
+
+        void Rect(int x0, int y0, int x1, int y1)
+        {
+            Span(y0, x0, x1);
+            Span(y1, x0, x1);
+            Column(x0, y0 + 1, y1 - 1);
+            Column(x1, y0 + 1, y1 - 1);
+
+            if (x1 - x0 < 2 || y1 - y0 < 2)
+                return; // no inner pixels
+
+            const int value = IterRow(f, y0)[x0];
+            if (BorderIsUniform(x0, y0, x1, y1, value))
+            {
+                // The norms run linearly between the left and right border, so smooth coloring
+                // shades the filled pixels instead of showing a flat block.
+                for (int y = y0 + 1; y < y1; ++y)
+                {
+                    std::fill(IterRow(f, y) + x0 + 1, IterRow(f, y) + x1, value);
+                    float* norms = NormRow(f, y);
+                    const float left = norms[x0], slope = (norms[x1] - left) / (x1 - x0);
+                    for (int x = x0 + 1; x < x1; ++x)
+                        norms[x] = left + slope * (x - x0);
+                }
+                return;
+            }
+
+            if (x1 - x0 <= kMinSubdivide && y1 - y0 <= kMinSubdivide)
+            {
+                for (int y = y0 + 1; y < y1; ++y)
+                    Span(y, x0 + 1, x1 - 1);
+                return;
+            }
+
+            // Split across the longer side (or both when roughly square).
+            const int xm = (x0 + x1) / 2;
+            const int ym = (y0 + y1) / 2;
+            const bool splitX = x1 - x0 > kMinSubdivide && 2 * (x1 - x0) >= (y1 - y0);
+            const bool splitY = y1 - y0 > kMinSubdivide && 2 * (y1 - y0) >= (x1 - x0);
+            if (splitX && splitY)
+            {
+                Rect(x0, y0, xm, ym);
+                Rect(xm, y0, x1, ym);
+                Rect(x0, ym, xm, y1);
+                Rect(xm, ym, x1, y1);
+            }
+            else if (splitX)
+            {
+                Rect(x0, y0, xm, y1);
+                Rect(xm, y0, x1, y1);
+            }
+            else
+            {
+                Rect(x0, y0, x1, ym);
+                Rect(x0, ym, x1, y1);
+            }
+        }
+    };
+
+    // Value of the block of the given size around (x, y) when its four corners agree, with the
+    // mean of their norms. Corners at or past (xEnd, yEnd) are not known yet.
+    bool GuessFromCorners(const FrameParams& f, int x, int y, int block, int xEnd, int yEnd, int& value, float& norm)
+    {
+        const int xa = x - x % block, ya = y - y % block;
+        const int xb = xa + block, yb = ya + block;
+        if (xb >= xEnd || yb >= yEnd)
+            return false;
+        const int v = IterRow(f, ya)[xa];
+        if (IterRow(f, ya)[xb] != v || IterRow(f, yb)[xa] != v || IterRow(f, yb)[xb] != v)
+            return false;
+        value = v;
+        norm = 0.25f * (NormRow(f, ya)[xa] + NormRow(f, ya)[xb] + NormRow(f, yb)[xa] + NormRow(f, yb)[xb]);
+        return true;
+    }
+
+    // Corners are read up to (xEnd, yEnd): the image size when every tile has finished the
+    // previous pass, the tile's own end otherwise.
+    void IterateTilePass(const FrameParams& f, int x0, int y0, int tw, int th, int step,
+                         int xEnd, int yEnd, TileStats& stats)
+    {
+        const int coarse = 2 * step;
+        int pending[kTileSize];
+        int counts[kTileSize];
+        float norms[kTileSize];
+
+        for (int y = y0; y < y0 + th; y += step)
+        {
+            // Rows on the coarser grid already have their even multiples of step.
+            const bool coarseRow = step < kFirstPassStep && y % coarse == 0;
+            const int first = x0 + (coarseRow ? step : 0);
+            const int stride = coarseRow ? coarse : step;
+
+            int* row = IterRow(f, y);
+            float* normRow = NormRow(f, y);
+            int n = 0;
+            for (int x = first; x < x0 + tw; x += stride)
+            {
+                if (step < kFirstPassStep && GuessFromCorners(f, x, y, coarse, xEnd, yEnd, row[x], normRow[x]))
+                    ++stats.guessed;
+                else
+                    pending[n++] = x;
+            }
+
+            // Evenly spaced runs of the rest go to the row kernel together.
+            RowParams params = RowFor(f, y);
+            params.stride = stride;
+            for (int i = 0; i < n; )
+            {
+                int end = i + 1;
+                while (end < n && pending[end] == pending[end - 1] + stride) ++end;
+                stats.skipped += f.iterateRow(params, pending[i], end - i, counts, norms);
+                for (int k = i; k < end; ++k)
+                {
+                    row[pending[k]] = counts[k - i];
+                    normRow[pending[k]] = norms[k - i];
+                }
+                stats.computed += end - i;
+                i = end;
+            }
+        }
+    }
+
+    void IterateTileMarianiSilver(const FrameParams& f, int x0, int y0, int tw, int th, TileStats& stats)
+    {
+        for (int y = y0; y < y0 + th; ++y)
+            std::fill(IterRow(f, y) + x0, IterRow(f, y) + x0 + tw, -1);
+
+        Subdivider s{ f, stats };
+        s.Rect(x0, y0, x0 + tw - 1, y0 + th - 1);
+    }
+
+    // Pixels re-rendered per task during glitch correction.
+    const int kGlitchChunk = 256;
+
+    // a * t + b * (1 - t) per channel, t in [0, 1].
+    uint32_t BlendColors(uint32_t a, uint32_t b, float t)
+    {
+        uint32_t out = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            const float ca = (float)((a >> shift) & 0xFF), cb = (float)((b >> shift) & 0xFF);
+            out |= (uint32_t)(cb + (ca - cb) * t + 0.5f) << shift;
+        }
+        return out;
+    }
+
+    // Colors count pixels of a row from their escape counts and norms (distance estimates with
+    // f.distance). Counts past the table (and the negative glitch marks a progressive pass may
+    // still show) take the inside color.
+    void ColorizeRun(const FrameParams& f, const int* iters, const float* norms, int count, uint32_t* out)
+    {
+        if (f.distance)
+        {
+            // Filaments thinner than a pixel would fall between samples; darkening by the
+            // distance estimate draws them at a pixel's width.
+            const unsigned inside = (unsigned)f.maxIter;
+            const uint32_t insideColor = f.palette[inside];
+            const float pixel = (float)f.scale;
+            for (int i = 0; i < count; ++i)
+            {
+                const uint32_t color = f.palette[std::min((unsigned)iters[i], inside)];
+                out[i] = (unsigned)iters[i] < inside && norms[i] < pixel
+                    ? BlendColors(color, insideColor, norms[i] / pixel) : color;
+            }
+            return;
+        }
+        if (f.paletteSteps > 1)
+        {
+            ColorizeSmoothRow(f.palette, f.maxIter, iters, norms, count, out);
+            return;
+        }
+        const unsigned inside = (unsigned)f.maxIter;
+        for (int i = 0; i < count; ++i)
+            out[i] = f.palette[std::min((unsigned)iters[i], inside)];
+    }
+
+    // Colors the tile from the iteration buffer with one palette lookup per pixel, smooth
+    // palettes from the norms too. With step > 1 only the pixels on that grid are known, and
+    // each colors its step x step block with the color of its escape count.
+    void ColorizeTile(const FrameParams& f, int x0, int y0, int tw, int th, int step = 1)
+    {
+        const unsigned inside = (unsigned)f.maxIter;
+        const uint32_t* palette = f.palette;
+        const unsigned steps = (unsigned)f.paletteSteps;
+
+        for (int y = y0; y < y0 + th; ++y)
+        {
+            const int* iters = IterRow(f, y - y % step);
+            uint32_t* row = f.pixels + (size_t)y * f.pitchPixels;
+
+            if (step == 1)
+            {
+                ColorizeRun(f, iters + x0, NormRow(f, y) + x0, tw, row + x0);
+            }
+            else
+            {
+                for (int x = x0; x < x0 + tw; ++x)
+                    row[x] = palette[std::min((unsigned)iters[x - x % step], inside) * steps];
+            }
+        }
+    }
+
+    // Adaptive antialiasing: neighbours whose colors differ by more than this (sum over the
+    // channels), or whose counts differ by more than half the smaller and at least
+    // kEdgeIterJump, mark both pixels as edges.
+    const int kEdgeColorDiff = 48;
+    const int kEdgeIterJump = 16;
+
+    bool IsEdge(uint32_t a, uint32_t b, int ia, int ib, int maxIter)
+    {
+        if ((ia >= maxIter) != (ib >= maxIter))
+            return true;
+        const int diff = std::abs((int)(a & 0xFF) - (int)(b & 0xFF)) +
+                         std::abs((int)((a >> 8) & 0xFF) - (int)((b >> 8) & 0xFF)) +
+                         std::abs((int)((a >> 16) & 0xFF) - (int)((b >> 16) & 0xFF));
+        if (diff > kEdgeColorDiff)
+            return true;
+        const int jump = std::abs(ia - ib);
+        return jump >= kEdgeIterJump && 2 * jump > std::min(ia, ib);
+    }
+
+    // Jittered rows of samples x samples sample offsets, in pixels within [-0.5, 0.5): row j
+    // sits at a fixed pseudo-random height dy[j] in the j-th stratum, and its samples are
+    // 1 / samples apart from a fixed pseudo-random start shift[j] / samples. Keeping each row
+    // evenly spaced lets the samples of a run of pixels go through the row kernel as one row.
+    void JitteredPattern(int samples, double* shift, double* dy)
+    {
+        uint32_t state = 0x9E3779B9u;
+        auto next = [&state]
+        {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) * (1.0 / (1 << 24));
+        };
+        for (int j = 0; j < samples; ++j)
+        {
+            shift[j] = next();
+            dy[j] = (j + next()) / samples - 0.5;
+        }
+    }
+}
+
+void IterateTile(const FrameParams& f, int tileX, int tileY, TileStats& stats)
+{
+    const int x0 = tileX * kTileSize;
+    const int y0 = tileY * kTileSize;
+    const int tw = std::min(kTileSize, f.width - x0);
+    const int th = std::min(kTileSize, f.height - y0);
+
+    if (f.mode == RenderMode::Progressive)
+    {
+        for (int step = kFirstPassStep; step >= 1; step /= 2)
+            IterateTilePass(f, x0, y0, tw, th, step, x0 + tw, y0 + th, stats);
+    }
+    else if (f.mode == RenderMode::MarianiSilver)
+        IterateTileMarianiSilver(f, x0, y0, tw, th, stats);
+    else
+        IterateTileBruteForce(f, x0, y0, tw, th, stats);
+}
+
+void RenderTilePass(const FrameParams& f, int tileX, int tileY, int step, TileStats& stats)
+{
+    const int x0 = tileX * kTileSize;
+    const int y0 = tileY * kTileSize;
+    const int tw = std::min(kTileSize, f.width - x0);
+    const int th = std::min(kTileSize, f.height - y0);
+
+    IterateTilePass(f, x0, y0, tw, th, step, f.width, f.height, stats);
+    if (step > 1)
+        ColorizeTile(f, x0, y0, tw, th, step);
+}
+
+void IterateRect(const FrameParams& f, int x0, int y0, int w, int h, TileStats& stats)
+{
+    IterateTileBruteForce(f, x0, y0, w, h, stats);
+}
+
+void ColorizeRect(const FrameParams& f, int x0, int y0, int w, int h)
+{
+    ColorizeTile(f, x0, y0, w, h);
+}
+
+void CountIterations(const FrameParams& f, int x0, int y0, int w, int h, uint32_t* histogram)
+{
+    for (int y = y0; y < y0 + h; ++y)
+    {
+        const int* iters = IterRow(f, y) + x0;
+        for (int x = 0; x < w; ++x)
+            if ((unsigned)iters[x] < (unsigned)f.maxIter)
+                ++histogram[iters[x]];
+    }
+}
+
+void IterateProbeGrid(const FrameParams& f, int step, int* iterations, float* norms, ThreadPool& pool)
+{
+    FrameParams probe = f;
+    probe.width = (f.width + step - 1) / step;
+    probe.height = (f.height + step - 1) / step;
+    probe.scale = f.scale * step;
+    probe.halfW = f.halfW / step;
+    probe.halfH = f.halfH / step;
+    probe.iterations = iterations;
+    probe.norms = norms;
+    probe.pixels = nullptr;
+
+    pool.ParallelFor(probe.height, [&](int y, int)
+    {
+        if (Cancelled(probe))
+            return;
+        TileStats stats;
+        IterateRect(probe, 0, y, probe.width, 1, stats);
+    });
+}
+
+void FindEdges(const FrameParams& f, int x0, int y0, int w, int h, uint8_t* edges)
+{
+    for (int y = y0; y < y0 + h; ++y)
+    {
+        const int* iters = IterRow(f, y);
+        const float* distances = NormRow(f, y);
+        const uint32_t* row = f.pixels + (size_t)y * f.pitchPixels;
+        uint8_t* out = edges + (size_t)y * f.width;
+        for (int x = x0; x < x0 + w; ++x)
+        {
+            bool edge = f.distance && iters[x] < f.maxIter && distances[x] < f.scale;
+            for (int ny = std::max(0, y - 1); ny <= std::min(f.height - 1, y + 1) && !edge; ++ny)
+            {
+                const int* nIters = IterRow(f, ny);
+                const uint32_t* nRow = f.pixels + (size_t)ny * f.pitchPixels;
+                for (int nx = std::max(0, x - 1); nx <= std::min(f.width - 1, x + 1) && !edge; ++nx)
+                    edge = IsEdge(row[x], nRow[nx], iters[x], nIters[nx], f.maxIter);
+            }
+            out[x] = edge;
+        }
+    }
+}
+
+long long SupersampleRect(const FrameParams& f, const uint8_t* edges, int samples, int x0, int y0, int w, int h)
+{
+    double shift[kMaxSamples], dy[kMaxSamples];
+    samples = std::clamp(samples, 1, kMaxSamples);
+    JitteredPattern(samples, shift, dy);
+
+    int iters[kTileSize * kMaxSamples];
+    float norms[kTileSize * kMaxSamples];
+    uint32_t colors[kTileSize * kMaxSamples];
+    uint32_t sums[kTileSize][4]; // b, g, r and the samples that were not glitched
+    long long supersampled = 0;
+
+    for (int y = y0; y < y0 + h; ++y)
+    {
+        const uint8_t* rowEdges = edges + (size_t)y * f.width;
+        uint32_t* row = f.pixels + (size_t)y * f.pitchPixels;
+
+        // Runs of edge pixels, at most a tile wide, share each sample's kernel call.
+        for (int x = x0; x < x0 + w;)
+        {
+            if (!rowEdges[x])
+            {
+                ++x;
+                continue;
+            }
+            const int xa = x;
+            while (x < x0 + w && x - xa < kTileSize && rowEdges[x])
+                ++x;
+            const int n = x - xa;
+
+            memset(sums, 0, sizeof(sums[0]) * n);
+            for (int j = 0; j < samples; ++j)
+            {
+                // A row of samples over the run is a frame row at 1 / samples the spacing:
+                // its sample k lies at x = xa - 0.5 + (k + shift[j]) / samples, y + dy[j].
+                FrameParams g = f;
+                g.scale = f.scale / samples;
+                g.halfW = samples * (f.halfW - xa + 0.5) - shift[j];
+                g.halfH = -samples * (y + dy[j] - f.halfH);
+                RowParams params = RowFor(g, 0);
+                g.iterateRow(params, 0, n * samples, iters, norms);
+                ColorizeRun(f, iters, norms, n * samples, colors);
+                for (int k = 0; k < n * samples; ++k)
+                {
+                    if (IsGlitched(iters[k]))
+                        continue;
+                    uint32_t* sum = sums[k / samples];
+                    sum[0] += colors[k] & 0xFF;
+                    sum[1] += (colors[k] >> 8) & 0xFF;
+                    sum[2] += (colors[k] >> 16) & 0xFF;
+                    ++sum[3];
+                }
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                const uint32_t count = sums[i][3];
+                if (count)
+                    row[xa + i] = ((sums[i][2] + count / 2) / count) << 16 |
+                                  ((sums[i][1] + count / 2) / count) << 8 |
+                                  ((sums[i][0] + count / 2) / count);
+            }
+            supersampled += n;
+        }
+    }
+    return supersampled;
+}
+
+void ScrollFrame(const FrameParams& f, const uint32_t* previous, size_t previousPitch, int dx, int dy)
+{
+    // Destination columns [xa, xa + n) read source columns [xa + dx, xa + dx + n).
+    const int xa = std::max(0, -dx);
+    const int n = f.width - std::abs(dx);
+    const int ya = std::max(0, -dy), yb = std::min(f.height, f.height - dy);
+
+    // Rows move in place, so walk them away from the side they move towards.
+    for (int i = 0; i < yb - ya; ++i)
+    {
+        const int y = dy > 0 ? ya + i : yb - 1 - i;
+        memmove(IterRow(f, y) + xa, IterRow(f, y + dy) + xa + dx, (size_t)n * sizeof(int));
+        memmove(NormRow(f, y) + xa, NormRow(f, y + dy) + xa + dx, (size_t)n * sizeof(float));
+        if (previous)
+            memcpy(f.pixels + (size_t)y * f.pitchPixels + xa, previous + (size_t)(y + dy) * previousPitch + xa + dx,
+                   (size_t)n * sizeof(uint32_t));
+    }
+}
+
+void ShrinkFrame(const FrameParams& f, const int* previousIters, const float* previousNorms,
+                 const uint32_t* previous, size_t previousPitch, int offX, int offY, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; ++y)
+    {
+        const size_t srcOffset = (size_t)(2 * y + offY) * f.width + offX;
+        const uint32_t* src = previous ? previous + (size_t)(2 * y + offY) * previousPitch + offX : nullptr;
+        int* iters = IterRow(f, y);
+        float* norms = NormRow(f, y);
+        uint32_t* row = f.pixels + (size_t)y * f.pitchPixels;
+        for (int x = x0; x < x1; ++x)
+        {
+            iters[x] = previousIters[srcOffset + 2 * x];
+            norms[x] = previousNorms[srcOffset + 2 * x];
+        }
+        if (previous)
+            for (int x = x0; x < x1; ++x)
+                row[x] = src[2 * x];
+    }
+}
+
+void CorrectGlitches(const FrameParams& f, const BigFixed& centerRe, const BigFixed& centerIm, int maxReferences,
+                     std::vector<ReferenceOrbit>& references, ThreadPool& pool, GlitchStats& stats)
+{
+    stats = GlitchStats();
+    const int w = f.width;
+    const size_t pixels = (size_t)w * f.height;
+
+    struct Group
+    {
+        std::vector<int> pixels;    // indices into f.iterations
+        int refX = 0, refY = 0;     // pixel the group's reference sits on
+        double dcMax = 0.0;         // farthest pixel from it, in world units
+    };
+
+    while (stats.references < maxReferences && !Cancelled(f))
+    {
+        // Connected (4-neighbour) blobs of glitched pixels, largest first.
+        std::vector<Group> groups;
+        std::vector<char> seen(pixels, 0);
+        std::vector<int> stack;
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            if (seen[i] || !IsGlitched(f.iterations[i]))
+                continue;
+            Group g;
+            seen[i] = 1;
+            stack.push_back((int)i);
+            while (!stack.empty())
+            {
+                const int p = stack.back();
+                stack.pop_back();
+                g.pixels.push_back(p);
+                const int x = p % w, y = p / w;
+                const int next[4][2] = { { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+                for (const auto& n : next)
+                {
+                    if (n[0] < 0 || n[0] >= w || n[1] < 0 || n[1] >= f.height)
+                        continue;
+                    const int q = n[1] * w + n[0];
+                    if (!seen[q] && IsGlitched(f.iterations[q]))
+                    {
+                        seen[q] = 1;
+                        stack.push_back(q);
+                    }
+                }
+            }
+            groups.push_back(std::move(g));
+        }
+        if (groups.empty())
+            break;
+
+        std::sort(groups.begin(), groups.end(),
+                  [](const Group& a, const Group& b) { return a.pixels.size() > b.pixels.size(); });
+        if ((int)groups.size() > maxReferences - stats.references)
+            groups.resize((size_t)(maxReferences - stats.references));
+
+        // The new reference goes on the group pixel nearest the centroid: inside the blob even
+        // when it is not convex, and rendered exactly there, so every round fixes some pixels.
+        for (Group& g : groups)
+        {
+            double sx = 0, sy = 0;
+            for (int p : g.pixels) { sx += p % w; sy += p / w; }
+            sx /= g.pixels.size();
+            sy /= g.pixels.size();
+            double best = -1, farthest = 0;
+            for (int p : g.pixels)
+            {
+                const double dx = p % w - sx, dy = p / w - sy;
+                if (best < 0 || dx * dx + dy * dy < best)
+                {
+                    best = dx * dx + dy * dy;
+                    g.refX = p % w;
+                    g.refY = p / w;
+                }
+            }
+            for (int p : g.pixels)
+            {
+                const double dx = p % w - g.refX, dy = p / w - g.refY;
+                farthest = std::max(farthest, dx * dx + dy * dy);
+            }
+            g.dcMax = ldexp(sqrt(farthest) * f.scale, f.scaleExp);
+        }
+
+        // One serial BigFixed orbit per reference, all references in parallel; each BLA table
+        // then uses the whole pool.
+        const size_t first = (size_t)stats.references;
+        if (references.size() < first + groups.size())
+            references.resize(first + groups.size());
+        pool.ParallelFor((int)groups.size(), [&](int i, int)
+        {
+            const Group& g = groups[(size_t)i];
+            const int limbs = std::max(centerRe.FractionLimbs(), centerIm.FractionLimbs());
+            const BigFixed re = centerRe + BigFixed::FromScaled((g.refX - f.halfW) * f.scale, f.scaleExp, limbs);
+            const BigFixed im = centerIm + BigFixed::FromScaled(-(g.refY - f.halfH) * f.scale, f.scaleExp, limbs);
+            ComputeReferenceOrbit(re, im, f.maxIter, references[first + (size_t)i]);
+        });
+        for (size_t i = 0; i < groups.size(); ++i)
+            BuildBlaTable(references[first + i], groups[i].dcMax, pool);
+
+        // Re-render every group pixel against its group's reference.
+        std::vector<std::pair<int, int>> work; // (pixel, group)
+        for (size_t i = 0; i < groups.size(); ++i)
+            for (int p : groups[i].pixels)
+                work.emplace_back(p, (int)i);
+        pool.ParallelFor((int)((work.size() + kGlitchChunk - 1) / kGlitchChunk), [&](int chunk, int)
+        {
+            if (Cancelled(f))
+                return;
+            const size_t end = std::min(work.size(), (size_t)(chunk + 1) * kGlitchChunk);
+            for (size_t k = (size_t)chunk * kGlitchChunk; k < end; ++k)
+            {
+                const int p = work[k].first;
+                const Group& g = groups[(size_t)work[k].second];
+                RowParams params{ 0.0, (double)g.refX, f.scale, -(p / w - g.refY) * f.scale, f.maxIter,
+                                  &references[first + (size_t)work[k].second] };
+                params.scaleExp = f.scaleExp;
+                params.rebase = f.rebase;
+                IterateRowPerturbation(params, p % w, 1, f.iterations + p, f.norms + p);
+            }
+        });
+
+        stats.references += (int)groups.size();
+        stats.rerendered += (long long)work.size();
+    }
+
+    if (Cancelled(f))
+        return;
+
+    // Out of references: keep the count at which the glitch was detected.
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        if (!IsGlitched(f.iterations[i]))
+            continue;
+        f.iterations[i] = GlitchedCount(f.iterations[i]);
+        ++stats.remaining;
+    }
+}
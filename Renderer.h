@@ -0,0 +1,150 @@
+#pragma once
+
+#include "MandelbrotKernels.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class BigFixed;
+class ThreadPool;
+
+// How RenderMandelbrot fills the iteration buffer of each tile.
+enum class RenderMode
+{
+    BruteForce,     // every pixel is iterated
+    MarianiSilver,  // rectangle borders are traced; uniform rectangles are filled, others split
+    Progressive,    // coarse-to-fine passes on grids of 8, 4, 2, 1 pixels with solid guessing
+};
+
+// Tiles are the unit of work handed to the pool; 64x64 gives a 1600x1200 frame ~475 tasks,
+// enough for stealing to even out interior-heavy and fast-escaping regions.
+const int kTileSize = 64;
+
+// Grid spacing of the first progressive pass; each later pass halves it down to 1.
+const int kFirstPassStep = 8;
+
+// Everything a worker needs to render one tile, captured once per frame so the pool
+// threads never read g_state while the UI thread may be changing it.
+struct FrameParams
+{
+    int width, height;
+    double centerX, centerY, scale;
+    double centerXLo, centerYLo; // double-double kernels: rest of the center below centerX/Y
+    int scaleExp;           // perturbation past the double range: pixel spacing is scale * 2^scaleExp
+    double halfW, halfH;
+    int maxIter;
+    RenderMode mode;
+    RowKernel iterateRow;   // widest kernel for runs of pixels
+    RowKernel iteratePixel; // scalar kernel of the same precision, for single pixels
+    const ReferenceOrbit* reference; // perturbation: center is then the offset from the reference
+    bool rebase;            // perturbation: see RowParams::rebase
+
+    int* iterations;        // width * height escape counts
+    float* norms;           // width * height |z|^2 at escape, beside iterations (smooth coloring)
+    uint32_t* pixels;       // BGRA DIB
+    size_t pitchPixels;
+
+    const uint32_t* palette; // maxIter * paletteSteps + 1 BGRA colors (see Palette)
+    int paletteSteps;       // 1: colored by escape count; kSmoothSteps: smooth coloring from norms
+    bool distance;          // norms hold exterior distance estimates in world units instead of
+                            // |z|^2 (iterateRow is a distance kernel); coloring darkens pixels
+                            // within one pixel of the set towards the inside color
+
+    const std::atomic<bool>* cancel; // set when a newer frame is wanted; null: never cancelled
+};
+
+// True once the frame has been cancelled. Checked before each tile, so a cancelled frame
+// stops within one tile per worker and leaves the buffers partly rendered.
+inline bool Cancelled(const FrameParams& f)
+{
+    return f.cancel && f.cancel->load(std::memory_order_relaxed);
+}
+
+// Per-tile counters, summed by RenderMandelbrot into the frame statistics.
+struct TileStats
+{
+    long long skipped = 0;  // pixels found in the cardioid/bulb without iterating
+    long long computed = 0; // pixels run through a kernel (the rest were filled)
+    long long guessed = 0;  // progressive: pixels filled from four equal block corners
+};
+
+// A frame is rendered in two phases: the iteration phase fills f.iterations and f.norms, then
+// the colorization phase (ColorizeRect) maps them to f.pixels. The buffers outlive the frame,
+// so a change of colors (or switching smooth coloring) only reruns the second phase.
+
+// Fills the tile's part of f.iterations according to f.mode. Progressive mode renders all
+// passes in one go; see RenderTilePass to show each.
+void IterateTile(const FrameParams& f, int tileX, int tileY, TileStats& stats);
+
+// One progressive pass over a tile: iterates the pixels on the grid of the given step that
+// earlier passes have not (step == kFirstPassStep: the whole grid). Passes with step > 1 then
+// color every grid pixel's step x step block with it for display; the last pass is colored
+// with the frame. Pixels whose coarser block (2 step) has four equal corners take that value
+// without iterating. All tiles must finish a pass before the next finer one starts, since
+// blocks read corners from neighbouring tiles.
+void RenderTilePass(const FrameParams& f, int tileX, int tileY, int step, TileStats& stats);
+
+// Iterates every pixel of the rectangle by brute force, whatever f.mode is. Used for the
+// strips a pan exposes, which match a full brute-force render exactly.
+void IterateRect(const FrameParams& f, int x0, int y0, int w, int h, TileStats& stats);
+
+// Colors the rectangle from f.iterations into f.pixels.
+void ColorizeRect(const FrameParams& f, int x0, int y0, int w, int h);
+
+// Adds the rectangle's escape counts to histogram (f.maxIter entries): histogram[n] counts
+// the pixels that escaped after n iterations. Pixels inside the set are not counted.
+void CountIterations(const FrameParams& f, int x0, int y0, int w, int h, uint32_t* histogram);
+
+// Largest number of samples per axis SupersampleRect takes.
+const int kMaxSamples = 8;
+
+// Adaptive antialiasing, after the colorization phase. FindEdges sets edges[y * width + x]
+// (0 or 1) for the rectangle's pixels whose color, escape count or inside/outside state
+// differs strongly from one of their eight neighbours, and with f.distance for escaped pixels
+// whose distance estimate is below one pixel. It reads f.pixels around the
+// rectangle, so all of it must be done before SupersampleRect writes any.
+void FindEdges(const FrameParams& f, int x0, int y0, int w, int h, uint8_t* edges);
+
+// Replaces every edge pixel of the rectangle by the mean color of samples x samples jittered
+// samples inside it: rows of samples at jittered heights, each evenly spaced from a jittered
+// start, the same for every pixel, so a run of edge pixels takes one kernel call per row of
+// samples. Returns the number of pixels supersampled.
+long long SupersampleRect(const FrameParams& f, const uint8_t* edges, int samples, int x0, int y0, int w, int h);
+
+// Iterates pixel (x step, y step) of the frame for every x < ceil(width / step) and
+// y < ceil(height / step) into iterations and norms, rows of ceil(width / step), in parallel
+// on pool. With step a power of two the probes match those pixels of a full render exactly.
+void IterateProbeGrid(const FrameParams& f, int step, int* iterations, float* norms, ThreadPool& pool);
+
+// Pans the frame: moves f.iterations and f.norms by (-dx, -dy) in place and, unless previous is null,
+// copies the matching pixels of the previous frame (pitch previousPitch, same size) into
+// f.pixels, so pixel (x, y) takes the values of previous pixel (x + dx, y + dy). The strips
+// left uncovered are not touched; |dx| < width and |dy| < height.
+void ScrollFrame(const FrameParams& f, const uint32_t* previous, size_t previousPitch, int dx, int dy);
+
+// Zooms the frame out by 2 on the same pixel grid: pixel (x, y) of [x0, x1) x [y0, y1) takes
+// the values of previous pixel (2x + offX, 2y + offY). previousIters, previousNorms and
+// previous (pitch previousPitch; null: iterations only) hold the previous frame, which has
+// the same size; the rest is not touched.
+void ShrinkFrame(const FrameParams& f, const int* previousIters, const float* previousNorms,
+                 const uint32_t* previous, size_t previousPitch, int offX, int offY, int x0, int y0, int x1, int y1);
+
+// Glitch correction counters of one frame.
+struct GlitchStats
+{
+    int references = 0;       // references added for glitched pixels
+    long long rerendered = 0; // pixel renders against them
+    long long remaining = 0;  // pixels still glitched when the reference budget ran out
+};
+
+// Perturbation frames only, after all tiles are rendered: groups the pixels marked glitched
+// into connected blobs and re-renders each blob against a new reference at the pixel nearest
+// its centroid. Pixels that glitch again are grouped again in the next round, until none are
+// left or maxReferences references were used; the rest keep the count at which their glitch
+// was detected. Runs before the colorization phase. The exact frame center (centerRe,
+// centerIm) places the new references; their orbits are kept in references. A cancelled
+// frame stops between rounds and chunks.
+void CorrectGlitches(const FrameParams& f, const BigFixed& centerRe, const BigFixed& centerIm, int maxReferences,
+                     std::vector<ReferenceOrbit>& references, ThreadPool& pool, GlitchStats& stats);
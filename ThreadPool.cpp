@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    // The thread calling ParallelFor works too, so start one fewer.
+    for (unsigned i = 0; i + 1 < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::WorkerMain, this, static_cast<int>(i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int, int)>& task)
+{
+    if (count <= 0) return;
+
+    std::lock_guard<std::mutex> job(m_jobLock);
+
+    m_task = &task;
+    m_remaining = count;
+
+    // Contiguous blocks keep neighbouring tiles on the same core until stealing kicks in.
+    const int workers = WorkerCount();
+    for (int w = 0; w < workers; ++w)
+    {
+        int begin = static_cast<int>(static_cast<long long>(count) * w / workers);
+        int end = static_cast<int>(static_cast<long long>(count) * (w + 1) / workers);
+
+        Queue& q = *m_queues[w];
+        std::lock_guard<std::mutex> lock(q.lock);
+        q.items.clear();
+        for (int i = begin; i < end; ++i)
+            q.items.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    RunTasks(workers - 1);
+
+    {
+        std::unique_lock<std::mutex> lock(m_wakeLock);
+        m_done.wait(lock, [this] { return m_remaining.load() == 0; });
+    }
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerMain(int worker)
+{
+    unsigned seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        RunTasks(worker);
+    }
+}
+
+void ThreadPool::RunTasks(int worker)
+{
+    int item;
+    while (PopOrSteal(worker, item))
+    {
+        (*m_task)(item, worker);
+
+        if (m_remaining.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_wakeLock);
+            m_done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::PopOrSteal(int worker, int& item)
+{
+    {
+        Queue& own = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.items.empty())
+        {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    // Own block is empty: take the last task of the next worker that still has some.
+    const int workers = WorkerCount();
+    for (int i = 1; i < workers; ++i)
+    {
+        Queue& victim = *m_queues[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.items.empty())
+        {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing thread pool used by the renderer.
+//
+// The threads are created once and sleep between jobs. ParallelFor deals the task indices
+// out in contiguous blocks, one block per worker; a worker takes tasks from the front of its
+// own block and, once that is empty, steals from the back of another worker's block. Tasks
+// of very different cost (interior tiles vs. tiles that escape quickly) therefore keep every
+// core busy until the job is done.
+class ThreadPool
+{
+public:
+    // threadCount == 0 uses one thread per hardware thread (the calling thread counts as one).
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers that run tasks, including the thread calling ParallelFor.
+    int WorkerCount() const { return static_cast<int>(m_queues.size()); }
+
+    // Runs task(index, worker) for every index in [0, count) and returns when all have finished.
+    // worker is in [0, WorkerCount()) and identifies the thread running the task, so tasks can
+    // use per-worker scratch data without locking. Calls from different threads are serialized.
+    void ParallelFor(int count, const std::function<void(int index, int worker)>& task);
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<int> items;
+    };
+
+    void WorkerMain(int worker);
+    void RunTasks(int worker);
+    bool PopOrSteal(int worker, int& item);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<Queue>> m_queues; // one per worker; the caller uses the last
+
+    std::mutex m_jobLock;                          // one ParallelFor at a time
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;                // new job or shutdown
+    std::condition_variable m_done;                // last task of the job finished
+    const std::function<void(int, int)>* m_task = nullptr;
+    std::atomic<int> m_remaining{ 0 };
+    unsigned m_generation = 0;
+    bool m_stop = false;
+};
@@ -0,0 +1,141 @@
+#include "TileCache.h"
+
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    // Tile grid pixels beyond this many from the origin leave the integers a double holds
+    // exactly, so their coordinates would no longer be multiples of the spacing.
+    const double kMaxGridPixel = 0x1p52;
+
+    long long FloorDiv(long long a, long long b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // Frame position of the tile's top left pixel.
+    void TileOrigin(const TileGrid& grid, const TileKey& key, long long& x0, long long& y0)
+    {
+        x0 = key.tx * kTileSize - grid.originX;
+        y0 = key.ty * kTileSize - grid.originY;
+    }
+}
+
+size_t TileKeyHash::operator()(const TileKey& key) const
+{
+    size_t h = std::hash<long long>()(key.tx);
+    auto mix = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+    mix(std::hash<long long>()(key.ty));
+    mix((size_t)key.level);
+    mix((size_t)key.maxIter);
+    mix(std::hash<RowKernel>()(key.kernel));
+    mix((size_t)key.mode);
+    return h;
+}
+
+void TileCache::SetBudget(size_t bytes)
+{
+    m_budget = bytes;
+    Evict();
+}
+
+const CachedTile* TileCache::Find(const TileKey& key)
+{
+    const auto it = m_index.find(key);
+    if (it == m_index.end())
+        return nullptr;
+    m_tiles.splice(m_tiles.begin(), m_tiles, it->second);
+    return &it->second->second;
+}
+
+void TileCache::Store(const TileKey& key, CachedTile&& tile)
+{
+    const auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        m_tiles.erase(it->second);
+        m_index.erase(it);
+    }
+    m_tiles.emplace_front(key, std::move(tile));
+    m_index.emplace(key, m_tiles.begin());
+    Evict();
+}
+
+void TileCache::Evict()
+{
+    while (!m_tiles.empty() && Bytes() > m_budget)
+    {
+        m_index.erase(m_tiles.back().first);
+        m_tiles.pop_back();
+    }
+}
+
+bool FindTileGrid(const FrameParams& f, TileGrid& grid)
+{
+    if (f.reference || f.scaleExp != 0 || f.centerXLo != 0.0 || f.centerYLo != 0.0)
+        return false;
+    int exponent;
+    if (frexp(f.scale, &exponent) != 0.5)
+        return false;
+
+    // Pixel (x, y) is at (centerX + (x - halfW) scale, centerY + (halfH - y) scale); dividing
+    // by a power of two is exact.
+    const double originX = f.centerX / f.scale - f.halfW;
+    const double originY = -f.centerY / f.scale - f.halfH;
+    if (originX != floor(originX) || originY != floor(originY) ||
+        fabs(originX) + f.width > kMaxGridPixel || fabs(originY) + f.height > kMaxGridPixel)
+        return false;
+
+    grid.level = exponent - 1;
+    grid.originX = (long long)originX;
+    grid.originY = (long long)originY;
+    return true;
+}
+
+void CoveringTiles(const FrameParams& f, const TileGrid& grid, std::vector<TileKey>& keys)
+{
+    const long long tx0 = FloorDiv(grid.originX, kTileSize), tx1 = FloorDiv(grid.originX + f.width - 1, kTileSize);
+    const long long ty0 = FloorDiv(grid.originY, kTileSize), ty1 = FloorDiv(grid.originY + f.height - 1, kTileSize);
+    keys.clear();
+    for (long long ty = ty0; ty <= ty1; ++ty)
+        for (long long tx = tx0; tx <= tx1; ++tx)
+            keys.push_back({ grid.level, tx, ty, f.maxIter, f.iterateRow, f.mode });
+}
+
+void IterateCacheTile(const FrameParams& f, const TileGrid& grid, const TileKey& key, CachedTile& tile, TileStats& stats)
+{
+    tile.iterations.resize((size_t)kTileSize * kTileSize);
+    tile.norms.resize(tile.iterations.size());
+
+    // Shifting the halves by the tile's position keeps (x - halfW) scale of every pixel the
+    // frame's, like a pan.
+    long long x0, y0;
+    TileOrigin(grid, key, x0, y0);
+    FrameParams t = f;
+    t.width = kTileSize;
+    t.height = kTileSize;
+    t.halfW = f.halfW - (double)x0;
+    t.halfH = f.halfH - (double)y0;
+    t.iterations = tile.iterations.data();
+    t.norms = tile.norms.data();
+    t.pixels = nullptr;
+    IterateTile(t, 0, 0, stats);
+}
+
+void CopyCacheTile(const FrameParams& f, const TileGrid& grid, const TileKey& key, const CachedTile& tile)
+{
+    long long x0, y0;
+    TileOrigin(grid, key, x0, y0);
+    const int xa = (int)std::max(0ll, x0), xb = (int)std::min((long long)f.width, x0 + kTileSize);
+    const int ya = (int)std::max(0ll, y0), yb = (int)std::min((long long)f.height, y0 + kTileSize);
+    for (int y = ya; y < yb; ++y)
+    {
+        const size_t src = (size_t)(y - y0) * kTileSize + (size_t)(xa - x0);
+        const size_t dst = (size_t)y * f.width + xa;
+        memcpy(f.iterations + dst, tile.iterations.data() + src, (size_t)(xb - xa) * sizeof(int));
+        memcpy(f.norms + dst, tile.norms.data() + src, (size_t)(xb - xa) * sizeof(float));
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Renderer.h"
+
+#include <list>
+#include <stddef.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// World space cut into a quadtree of tiles: at every power-of-two pixel spacing 2^level,
+// pixel (i, j) of the level sits at (i, -j) * 2^level (rows downward like the frame) and tile
+// (tx, ty) holds its pixels tx * kTileSize + [0, kTileSize) x ty * kTileSize + [0, kTileSize).
+// Each tile covers four of the next finer level. The rest of the key is what else changes
+// the iteration data.
+struct TileKey
+{
+    int level;
+    long long tx, ty;
+    int maxIter;
+    RowKernel kernel;       // lane precision and distance estimation
+    RenderMode mode;        // Mariani-Silver and progressive fills differ from brute force
+
+    bool operator==(const TileKey& o) const
+    {
+        return level == o.level && tx == o.tx && ty == o.ty && maxIter == o.maxIter &&
+               kernel == o.kernel && mode == o.mode;
+    }
+};
+
+struct TileKeyHash
+{
+    size_t operator()(const TileKey& key) const;
+};
+
+// Iteration data of one tile, kTileSize x kTileSize of each.
+struct CachedTile
+{
+    std::vector<int> iterations;
+    std::vector<float> norms;
+};
+
+// Bytes of iteration data a cached tile holds.
+const size_t kCachedTileBytes = (size_t)kTileSize * kTileSize * (sizeof(int) + sizeof(float));
+
+// Least recently used tiles are evicted once the tiles would take more than the budget.
+// Render thread only: it looks tiles up and stores them between the pool's parallel phases.
+class TileCache
+{
+public:
+    // Evicts down to the new budget; 0 empties the cache.
+    void SetBudget(size_t bytes);
+    size_t Budget() const { return m_budget; }
+    size_t Bytes() const { return m_index.size() * kCachedTileBytes; }
+
+    // The tile stored under key, now the most recently used; null when it is not cached. The
+    // pointer stays valid until the next Store or SetBudget.
+    const CachedTile* Find(const TileKey& key);
+
+    // Stores the tile as the most recently used, replacing one under the same key.
+    void Store(const TileKey& key, CachedTile&& tile);
+
+private:
+    void Evict();
+
+    using Entry = std::pair<TileKey, CachedTile>;
+    std::list<Entry> m_tiles; // most recently used first
+    std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash> m_index;
+    size_t m_budget = 0;
+};
+
+// Where a frame lies on the tile grid: frame pixel (x, y) is pixel (originX + x, originY + y)
+// of level.
+struct TileGrid
+{
+    int level;
+    long long originX, originY;
+};
+
+// A frame lines up with the grid when its spacing is a power of two and every pixel is a
+// whole multiple of it: plain (not perturbation) frames whose pan anchor is exact in a double
+// and sits on a pixel of the level (or half a pixel off it when halfW / halfH is a half
+// pixel), within 2^52 pixels of the origin. Such pixels get bit-identical coordinates
+// whichever frame they are iterated in. Returns false for any other frame.
+bool FindTileGrid(const FrameParams& f, TileGrid& grid);
+
+// Keys of the tiles the frame overlaps, in rows from the top left.
+void CoveringTiles(const FrameParams& f, const TileGrid& grid, std::vector<TileKey>& keys);
+
+// Iterates the whole tile, also the part outside the frame, into tile with the frame's
+// kernels and mode: the tile is rendered as a frame of its own, placed on the same grid.
+void IterateCacheTile(const FrameParams& f, const TileGrid& grid, const TileKey& key, CachedTile& tile, TileStats& stats);
+
+// Copies the part of the tile inside the frame into f.iterations and f.norms.
+void CopyCacheTile(const FrameParams& f, const TileGrid& grid, const TileKey& key, const CachedTile& tile);
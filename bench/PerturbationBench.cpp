@@ -0,0 +1,128 @@
+// Perturbation timings at several depths around c = i, a Misiurewicz point: every depth shows
+// structure and the reference never escapes. For each pixel spacing it times the reference
+// orbit, the series approximation and the BLA table, then a 160x120 frame on one thread with
+// the series and the BLA table, with the series only, and with neither (fastest of 3 runs).
+//
+//     PerturbationBench [spacing ...]      default: 1e-18 1e-25 1e-50 1e-100 1e-200 1e-400 1e-1000
+//
+// Below 2^kMinPlainScaleExponent (about 1e-289) the spacing is a mantissa and an exponent,
+// as in the application, and the offsets are iterated with their own exponent.
+
+#include "FloatExp.h"
+#include "Perturbation.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+    const int kWidth = 160, kHeight = 120, kMaxIter = 20000;
+
+    double MsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct FrameResult
+    {
+        double ms = 0.0;
+        long long iterations = 0;   // sum of the escape counts, skipped iterations included
+        long long glitched = 0;
+        std::vector<int> iters;
+    };
+
+    // Renders the frame centered on the reference row by row on this thread; the fastest of
+    // kRuns runs counts.
+    void RenderFrame(const ReferenceOrbit& orbit, double scale, int scaleExp, FrameResult& r)
+    {
+        const int kRuns = 3;
+        r.iters.resize((size_t)kWidth * kHeight);
+        std::vector<float> norms(kWidth);
+        r.ms = HUGE_VAL;
+        for (int run = 0; run < kRuns; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int y = 0; y < kHeight; ++y)
+            {
+                RowParams p{ 0.0, kWidth / 2.0, scale, -(y - kHeight / 2.0) * scale, kMaxIter, &orbit };
+                p.scaleExp = scaleExp;
+                IterateRowPerturbation(p, 0, kWidth, r.iters.data() + (size_t)y * kWidth, norms.data());
+            }
+            r.ms = fmin(r.ms, MsSince(start));
+        }
+        for (int n : r.iters)
+        {
+            r.glitched += IsGlitched(n);
+            r.iterations += IsGlitched(n) ? GlitchedCount(n) : n;
+        }
+    }
+
+    void PrintFrame(const char* name, const FrameResult& r, const FrameResult& plain)
+    {
+        long long differences = 0;
+        for (size_t i = 0; i < r.iters.size(); ++i)
+            differences += r.iters[i] != plain.iters[i];
+        printf("  %-14s %9.1f ms %9.1f ns/pixel %7.2f ns/iteration  %lld glitched, %lld differ from plain\n", name, r.ms,
+               1e6 * r.ms / r.iters.size(), 1e6 * r.ms / r.iterations, r.glitched, differences);
+    }
+
+    void Bench(const char* text, ThreadPool& pool)
+    {
+        FloatExp spacing;
+        if (!FloatExp::Parse(text, spacing) || spacing.m <= 0.0)
+        {
+            fprintf(stderr, "not a pixel spacing: %s\n", text);
+            return;
+        }
+        double scale = spacing.ToDouble();
+        int scaleExp = 0;
+        if (spacing.e <= kMinPlainScaleExponent)
+        {
+            scale = spacing.m;
+            scaleExp = spacing.e;
+        }
+        const int limbs = BigFixed::LimbsForScale(scale, scaleExp);
+
+        ReferenceOrbit orbit;
+        auto start = std::chrono::steady_clock::now();
+        ComputeReferenceOrbit(BigFixed(0.0, limbs), BigFixed(1.0, limbs), kMaxIter, orbit);
+        const double referenceMs = MsSince(start);
+
+        // Extents and BLA radius as RenderMandelbrot sets them for an unpanned view.
+        start = std::chrono::steady_clock::now();
+        ApproximateSeries(orbit, kWidth / 2.0 * scale, kHeight / 2.0 * scale, scale, scaleExp);
+        const double seriesMs = MsSince(start);
+        start = std::chrono::steady_clock::now();
+        BuildBlaTable(orbit, ldexp(hypot(kWidth / 2.0, kHeight / 2.0) * scale, scaleExp), pool);
+        const double blaMs = MsSince(start);
+
+        printf("%s per pixel: reference %zu iterations in %.1f ms, series skips %d in %.2f ms, BLA %zu levels in %.1f ms\n",
+               text, orbit.zx.size() - 1, referenceMs, orbit.series.iterations, seriesMs, orbit.bla.levels.size(), blaMs);
+
+        FrameResult full, series, plain;
+        RenderFrame(orbit, scale, scaleExp, full);
+        orbit.bla = BlaTable();
+        RenderFrame(orbit, scale, scaleExp, series);
+        orbit.series = SeriesSkip();
+        RenderFrame(orbit, scale, scaleExp, plain);
+        PrintFrame("series + BLA", full, plain);
+        PrintFrame("series", series, plain);
+        PrintFrame("plain", plain, plain);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ThreadPool pool;
+    const char* defaults[] = { "1e-18", "1e-25", "1e-50", "1e-100", "1e-200", "1e-400", "1e-1000" };
+    if (argc > 1)
+        for (int i = 1; i < argc; ++i)
+            Bench(argv[i], pool);
+    else
+        for (const char* text : defaults)
+            Bench(text, pool);
+    return 0;
+}
@@ -17,6 +17,7 @@
 #include <windows.h>
 #include <windowsx.h>
 #include <stdint.h>
+#include <float.h>
 #include <math.h>
 #include <string>
 
@@ -118,12 +119,28 @@ static void RenderMandelbrot(AppState& s) {
             int iter = 0;
             double zx2 = 0.0, zy2 = 0.0;
 
+            // Brent periodicity check: save z at power-of-two iterations; an orbit that comes
+            // back to within rounding (4 epsilons of |z|) has settled on a cycle and is interior.
+            double savedX = 0.0, savedY = 0.0;
+            int nextSave = 1;
+
             while (zx2 + zy2 <= 4.0 && iter < maxIter) {
                 zy = 2.0 * zx * zy + imag;
                 zx = zx2 - zy2 + real;
                 zx2 = zx * zx;
                 zy2 = zy * zy;
                 ++iter;
+
+                const double cycleTol = 4.0 * DBL_EPSILON * (fabs(zx) + fabs(zy));
+                if (fabs(zx - savedX) <= cycleTol && fabs(zy - savedY) <= cycleTol) {
+                    iter = maxIter;
+                    break;
+                }
+                if (iter == nextSave) {
+                    savedX = zx;
+                    savedY = zy;
+                    nextSave *= 2;
+                }
             }
 
             uint8_t r = 0, g = 0, b = 0;
@@ -0,0 +1,52 @@
+// Distance estimates at double-double depth, around the Misiurewicz point c = i: it belongs to
+// the set and every depth shows filaments. The estimate of every escaped pixel must be
+// positive (a derivative whose square overflowed used to give 0, so whole frames blended to
+// the inside color) and at most twice its distance to i, which bounds its distance to the set.
+
+#include "TestSupport.h"
+
+#include <math.h>
+
+int main()
+{
+    const int width = 160, height = 120;
+    const double scales[] = { 1e-18, 1e-22, 1e-26 };
+
+    std::vector<int> iters;
+    std::vector<float> norms;
+    for (double scale : scales)
+    {
+        const ReferenceView view{ "c = i", 0.0, 1.0, scale, 2000 };
+        CHECK(!DoublePrecisionSuffices(-width * scale, width * scale, 1.0 - height * scale, 1.0 + height * scale, scale));
+        for (int isa = (int)KernelIsa::Scalar; isa <= (int)DetectKernelIsa(); ++isa)
+        {
+            FrameParams f = ViewFrame(view, width, height, RenderMode::BruteForce, iters, norms);
+            f.iterateRow = GetRowKernel((KernelIsa)isa, KernelPrecision::DoubleDouble, true);
+            f.iteratePixel = GetRowKernel(KernelIsa::Scalar, KernelPrecision::DoubleDouble, true);
+            f.distance = true;
+            TileStats stats;
+            IterateRect(f, 0, 0, width, height, stats);
+
+            long long escaped = 0, zero = 0, tooFar = 0, withinPixel = 0;
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                {
+                    const size_t i = (size_t)y * width + x;
+                    if (iters[i] >= view.maxIter)
+                        continue;
+                    ++escaped;
+                    const double toI = hypot(x - f.halfW, f.halfH - y) * scale;
+                    zero += !(norms[i] > 0.0f);
+                    tooFar += norms[i] > 2.2 * toI;
+                    withinPixel += norms[i] < (float)scale;
+                }
+            printf("%g per pixel, %s: %lld escaped, %lld within a pixel of the set\n", scale,
+                   KernelIsaName((KernelIsa)isa), escaped, withinPixel);
+            CHECK(escaped > 0);
+            CHECK(zero == 0);
+            CHECK(tooFar == 0);
+            CHECK(withinPixel < escaped);
+        }
+    }
+    return TestResult("DistanceTest");
+}
@@ -0,0 +1,74 @@
+// Every vector kernel the CPU supports, in every precision and with distance estimation, must
+// return exactly the counts and norms of the scalar kernel of that precision, and the double
+// scalar kernel exactly the counts of the plain loop.
+
+#include "TestSupport.h"
+
+#include <string.h>
+
+namespace
+{
+    const KernelPrecision kPrecisions[] = { KernelPrecision::Double, KernelPrecision::Float, KernelPrecision::DoubleDouble };
+
+    // Pixels whose count or norm bits differ.
+    long long CountDifferences(const std::vector<int>& iters, const std::vector<float>& norms,
+                               const std::vector<int>& refIters, const std::vector<float>& refNorms)
+    {
+        long long differences = 0;
+        for (size_t i = 0; i < iters.size(); ++i)
+            if (iters[i] != refIters[i] || memcmp(&norms[i], &refNorms[i], sizeof(float)) != 0)
+                ++differences;
+        return differences;
+    }
+}
+
+int main()
+{
+    const KernelIsa widest = DetectKernelIsa();
+    printf("widest kernel: %s\n", KernelIsaName(widest));
+
+    std::vector<int> iters, refIters, plainIters;
+    std::vector<float> norms, refNorms;
+    for (const ReferenceView& view : kReferenceViews)
+    {
+        long long mismatches = 0;
+        for (int y = 0; y < kViewHeight; ++y)
+        {
+            const RowParams p = ViewRow(view, y);
+            for (int x = 0; x < kViewWidth; ++x)
+                plainIters.push_back(PlainEscapeCount(p.cx + (x - p.halfW) * p.scale, p.imag, view.maxIter));
+        }
+
+        for (KernelPrecision precision : kPrecisions)
+        {
+            std::vector<int> countIters;
+            for (bool distance : { false, true })
+            {
+                RenderView(GetRowKernel(KernelIsa::Scalar, precision, distance), view, refIters, refNorms);
+                if (!distance)
+                    countIters = refIters;
+                else if (!CHECK(refIters == countIters))
+                    printf("%s, %s: distance estimation changes the counts\n", view.name, KernelPrecisionName(precision));
+                if (precision == KernelPrecision::Double && !distance)
+                {
+                    for (size_t i = 0; i < refIters.size(); ++i)
+                        mismatches += refIters[i] != plainIters[i];
+                    if (!CHECK(mismatches == 0))
+                        printf("%s: %lld pixels differ from the plain loop\n", view.name, mismatches);
+                }
+
+                for (int isa = (int)KernelIsa::SSE2; isa <= (int)widest; ++isa)
+                {
+                    RenderView(GetRowKernel((KernelIsa)isa, precision, distance), view, iters, norms);
+                    const long long differences = CountDifferences(iters, norms, refIters, refNorms);
+                    if (!CHECK(differences == 0))
+                        printf("%s, %s %s%s: %lld pixels differ from the scalar kernel\n", view.name,
+                               KernelIsaName((KernelIsa)isa), KernelPrecisionName(precision),
+                               distance ? " distance" : "", differences);
+                }
+            }
+        }
+        plainIters.clear();
+    }
+    return TestResult("KernelTest");
+}
@@ -0,0 +1,31 @@
+// Mariani-Silver against brute force on standard views: the same counts (it can only miss
+// features enclosed by a uniform border, which none of these views has at this size), from a
+// fraction of the kernel work.
+
+#include "TestSupport.h"
+
+int main()
+{
+    const int width = 640, height = 480;
+    const ReferenceView views[] = {
+        { "default", -0.75, 0.0, 3.0 / width, 1000 },
+        { "seahorse", -0.7453, 0.1127, 1e-6, 5000 },
+        { "elephant", 0.2850, 0.0109, 1e-5, 5000 },
+    };
+
+    std::vector<int> bruteIters, iters;
+    std::vector<float> bruteNorms, norms;
+    for (const ReferenceView& view : views)
+    {
+        IterateFrame(ViewFrame(view, width, height, RenderMode::BruteForce, bruteIters, bruteNorms));
+        const long long computed = IterateFrame(ViewFrame(view, width, height, RenderMode::MarianiSilver, iters, norms));
+
+        long long mismatches = 0;
+        for (size_t i = 0; i < iters.size(); ++i)
+            mismatches += iters[i] != bruteIters[i];
+        printf("%s: %lld pixels differ, %.1f%% computed\n", view.name, mismatches, 100.0 * computed / iters.size());
+        CHECK(mismatches == 0);
+        CHECK(computed < (long long)iters.size());
+    }
+    return TestResult("MarianiSilverTest");
+}
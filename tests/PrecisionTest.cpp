@@ -0,0 +1,82 @@
+// Automatic precision: just inside FloatPrecisionSuffices(), a float frame may differ from the
+// double one on no more pixels than shifting the double frame by 1/1000 of a pixel changes -
+// sampling noise, not lost precision. The thresholds must also come in order, so the automatic
+// choice steps from float to double to double-double as the view zooms in.
+
+#include "TestSupport.h"
+
+#include <math.h>
+
+namespace
+{
+    typedef bool (*PrecisionTest)(double minX, double maxX, double minY, double maxY, double scale);
+
+    // Extent of the view's pixels at the given spacing, as RenderMandelbrot computes it.
+    bool Suffices(PrecisionTest test, const ReferenceView& view, double scale)
+    {
+        const double minX = view.centerX - kViewWidth / 2.0 * scale, maxX = view.centerX + kViewWidth / 2.0 * scale;
+        const double minY = view.centerY - kViewHeight / 2.0 * scale, maxY = view.centerY + kViewHeight / 2.0 * scale;
+        return test(minX, maxX, minY, maxY, scale);
+    }
+
+    // Smallest spacing the test accepts for the view, to within a part in 1e6.
+    double Threshold(PrecisionTest test, const ReferenceView& view)
+    {
+        double lo = 1e-40, hi = 1.0;
+        while (hi / lo > 1.000001)
+        {
+            const double mid = sqrt(lo * hi);
+            (Suffices(test, view, mid) ? hi : lo) = mid;
+        }
+        return hi;
+    }
+
+    long long CountDifferences(const std::vector<int>& a, const std::vector<int>& b)
+    {
+        long long differences = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            differences += a[i] != b[i];
+        return differences;
+    }
+
+    void CheckFloatThreshold(const ReferenceView& base)
+    {
+        ReferenceView view = base;
+        const double threshold = Threshold(FloatPrecisionSuffices, view);
+        CHECK(!Suffices(FloatPrecisionSuffices, view, 0.99 * threshold));
+        view.scale = 1.01 * threshold;
+        if (!CHECK(Suffices(FloatPrecisionSuffices, view, view.scale)))
+            return;
+
+        const KernelIsa isa = DetectKernelIsa();
+        std::vector<int> floatIters, doubleIters, shiftedIters;
+        std::vector<float> norms;
+        RenderView(GetRowKernel(isa, KernelPrecision::Float), view, floatIters, norms);
+        RenderView(GetRowKernel(isa, KernelPrecision::Double), view, doubleIters, norms);
+        ReferenceView shifted = view;
+        shifted.centerX += view.scale / 1000.0;
+        RenderView(GetRowKernel(isa, KernelPrecision::Double), shifted, shiftedIters, norms);
+
+        const long long precisionDifferences = CountDifferences(floatIters, doubleIters);
+        const long long shiftDifferences = CountDifferences(shiftedIters, doubleIters);
+        printf("%s at %.3g: %lld pixels differ in float, %lld after a 1/1000 pixel shift\n", view.name, view.scale,
+               precisionDifferences, shiftDifferences);
+        CHECK(precisionDifferences <= shiftDifferences);
+    }
+}
+
+int main()
+{
+    for (const ReferenceView& view : kReferenceViews)
+    {
+        CheckFloatThreshold(view);
+
+        const double floatThreshold = Threshold(FloatPrecisionSuffices, view);
+        const double doubleThreshold = Threshold(DoublePrecisionSuffices, view);
+        const double doubleDoubleThreshold = Threshold(DoubleDoublePrecisionSuffices, view);
+        CHECK(!Suffices(DoublePrecisionSuffices, view, 0.99 * doubleThreshold));
+        CHECK(!Suffices(DoubleDoublePrecisionSuffices, view, 0.99 * doubleDoubleThreshold));
+        CHECK(floatThreshold > doubleThreshold && doubleThreshold > doubleDoubleThreshold);
+    }
+    return TestResult("PrecisionTest");
+}
@@ -0,0 +1,54 @@
+// Smooth coloring's polynomial log2 against libm: its error stays far below one palette step,
+// and ColorizeSmoothRow picks the entry of the libm smooth count (or its neighbour, where the
+// count lies within that error of an entry boundary). Inside pixels take the last entry.
+
+#include "Palette.h"
+#include "TestSupport.h"
+
+#include <float.h>
+#include <math.h>
+
+int main()
+{
+    const double maxError = SmoothIterationMaxError();
+    printf("largest smooth count error: %.2e iterations\n", maxError);
+    CHECK(maxError < 1.0 / kSmoothSteps);
+
+    // A palette whose entries are their own indices shows which entry each pixel took.
+    const int maxIter = 100;
+    const int entries = maxIter * kSmoothSteps + 1;
+    std::vector<uint32_t> palette(entries);
+    for (int k = 0; k < entries; ++k)
+        palette[k] = (uint32_t)k;
+
+    std::vector<int> iters;
+    std::vector<float> norms;
+    for (double norm = 4.01; norm < FLT_MAX; norm *= 1.37)
+        for (int n = 0; n <= maxIter; n += 7)
+        {
+            iters.push_back(n);
+            norms.push_back((float)norm);
+        }
+    for (int n : { maxIter, -1 })
+    {
+        iters.push_back(n);
+        norms.push_back(0.0f);
+    }
+    std::vector<uint32_t> out(iters.size());
+    ColorizeSmoothRow(palette.data(), maxIter, iters.data(), norms.data(), (int)iters.size(), out.data());
+
+    long long wrong = 0;
+    for (size_t i = 0; i < iters.size(); ++i)
+    {
+        long long expected = entries - 1;
+        if (iters[i] >= 0 && iters[i] < maxIter)
+        {
+            expected = (long long)floor(SmoothIteration(iters[i], norms[i]) * kSmoothSteps);
+            expected = expected < 0 ? 0 : expected > entries - 2 ? entries - 2 : expected;
+        }
+        wrong += llabs((long long)out[i] - expected) > (iters[i] >= 0 && iters[i] < maxIter ? 1 : 0);
+    }
+    if (!CHECK(wrong == 0))
+        printf("%lld of %zu pixels more than one entry off\n", wrong, iters.size());
+    return TestResult("SmoothColoringTest");
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// Shared by the headless tests: checks that count their failures, the reference views and the
+// plain escape-time loop every kernel has to reproduce.
+
+#include "MandelbrotKernels.h"
+#include "Renderer.h"
+
+#include <stdio.h>
+#include <vector>
+
+inline int& FailedChecks()
+{
+    static int failed = 0;
+    return failed;
+}
+
+inline bool Check(bool ok, const char* expression, const char* file, int line)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+        ++FailedChecks();
+    }
+    return ok;
+}
+
+#define CHECK(condition) Check((condition), #condition, __FILE__, __LINE__)
+
+// Exit code of a test: 0 when every check passed.
+inline int TestResult(const char* name)
+{
+    printf("%s: %s\n", name, FailedChecks() ? "FAILED" : "passed");
+    return FailedChecks() ? 1 : 0;
+}
+
+struct ReferenceView
+{
+    const char* name;
+    double centerX, centerY, scale;
+    int maxIter;
+};
+
+// The whole set, seahorse valley, an area of small bulbs, the cusp, a component boundary
+// where orbits linger near weakly repelling cycles, and a minibrot at 1e-9 per pixel.
+const ReferenceView kReferenceViews[] = {
+    { "default", -0.75, 0.0, 3.0 / 160, 1000 },
+    { "seahorse", -0.7453, 0.1127, 1e-6, 5000 },
+    { "bulbs", -0.1, 0.9, 1e-4, 5000 },
+    { "cusp", 0.25, 0.0, 1e-7, 5000 },
+    { "elephant", 0.2850, 0.0109, 1e-5, 5000 },
+    { "minibrot", -1.7685736562, 0.0017937, 1e-9, 5000 },
+};
+
+const int kViewWidth = 160, kViewHeight = 120;
+
+// The loop the kernels replace, as the first version of the renderer ran it on every pixel.
+inline int PlainEscapeCount(double real, double imag, int maxIter)
+{
+    double zx = 0.0, zy = 0.0;
+    int n = 0;
+    while (n < maxIter)
+    {
+        const double x2 = zx * zx, y2 = zy * zy;
+        if (x2 + y2 > 4.0)
+            break;
+        const double t = x2 - y2 + real;
+        zy = 2.0 * zx * zy + imag;
+        zx = t;
+        ++n;
+    }
+    return n;
+}
+
+// Row y of the view, placed like the renderer places it.
+inline RowParams ViewRow(const ReferenceView& view, int y, int width = kViewWidth, int height = kViewHeight)
+{
+    RowParams p{ view.centerX, width / 2.0, view.scale, view.centerY - (y - height / 2.0) * view.scale, view.maxIter };
+    return p;
+}
+
+// Runs the kernel over every row of the view into iters and norms, row after row.
+inline void RenderView(RowKernel kernel, const ReferenceView& view, std::vector<int>& iters, std::vector<float>& norms,
+                       int width = kViewWidth, int height = kViewHeight)
+{
+    iters.assign((size_t)width * height, -1);
+    norms.assign(iters.size(), -1.0f);
+    for (int y = 0; y < height; ++y)
+        kernel(ViewRow(view, y, width, height), 0, width, iters.data() + (size_t)y * width, norms.data() + (size_t)y * width);
+}
+
+// Frame of the view for the iteration phase, with the widest double kernels, into iters and
+// norms (sized here). No pixels or palette: the tests compare iteration data only.
+inline FrameParams ViewFrame(const ReferenceView& view, int width, int height, RenderMode mode,
+                             std::vector<int>& iters, std::vector<float>& norms)
+{
+    iters.assign((size_t)width * height, -1);
+    norms.assign(iters.size(), -1.0f);
+    FrameParams f = {};
+    f.width = width;
+    f.height = height;
+    f.centerX = view.centerX;
+    f.centerY = view.centerY;
+    f.scale = view.scale;
+    f.halfW = width / 2.0;
+    f.halfH = height / 2.0;
+    f.maxIter = view.maxIter;
+    f.mode = mode;
+    f.iterateRow = GetRowKernel(DetectKernelIsa());
+    f.iteratePixel = GetRowKernel(KernelIsa::Scalar);
+    f.rebase = true;
+    f.iterations = iters.data();
+    f.norms = norms.data();
+    f.paletteSteps = 1;
+    return f;
+}
+
+// Runs IterateTile over every tile of the frame; returns the pixels run through a kernel.
+inline long long IterateFrame(const FrameParams& f)
+{
+    TileStats stats;
+    for (int ty = 0; ty * kTileSize < f.height; ++ty)
+        for (int tx = 0; tx * kTileSize < f.width; ++tx)
+            IterateTile(f, tx, ty, stats);
+    return stats.computed;
+}